@@ -0,0 +1,126 @@
+// Bus - Angelo Z. (2025)
+
+/*
+  I2C bus behind the TCA9548A mux (0x70).
+
+  select() writes the mux only when the channel changes. Work that
+  needs a channel can be posted as a job instead: run() executes the
+  jobs of the active channel first, then the others one channel at a
+  time, so a pass of the loop switches the mux as few times as
+  possible.
+
+      post(SCREEN, flush)     SCREEN: flush, progress
+      post(EEPROM, commit)    EEPROM: commit
+      post(SCREEN, progress)
+                              -> one switch instead of three
+*/
+#ifndef BUS_H
+#define BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define MUX_ADDR    0x70
+#define NO_CHANNEL  0xff
+#define MAX_JOBS    6
+
+
+typedef struct {
+    uint8_t channel;
+    void (*run)(void);
+} BusJob;
+
+
+class I2CBus {
+public:
+    // Statistics
+    uint16_t switches;
+    uint16_t avoided;
+
+    I2CBus() {
+        channel = NO_CHANNEL;
+        jobs = 0;
+        switches = avoided = 0;
+    }
+
+    uint8_t active() {
+        return channel;
+    }
+
+    /*
+    =====================
+     void select
+    =====================
+    */
+    void select(uint8_t ch) {
+        if (ch > 7) return;
+
+        if (ch == channel) {
+            avoided++;
+            return;
+        }
+
+        Wire.beginTransmission(MUX_ADDR);
+        Wire.write(1 << ch);
+        Wire.endTransmission();
+        // The mux switches on the stop condition, no need to wait
+        channel = ch;
+        switches++;
+    }
+
+    /*
+    =====================
+     boolean post
+    =====================
+    */
+    // Queue a job for the channel. The same job is queued once.
+    boolean post(uint8_t ch, void (*fn)(void)) {
+        for (uint8_t i = 0; i < jobs; i++)
+            if (queue[i].run == fn && queue[i].channel == ch) return true;
+
+        if (jobs == MAX_JOBS) return false;
+
+        queue[jobs].channel = ch;
+        queue[jobs].run = fn;
+        jobs++;
+
+        return true;
+    }
+
+    /*
+    =====================
+     void run
+    =====================
+    */
+    void run() {
+        while (jobs > 0) {
+            int8_t i = find(channel);
+
+            // Nothing left here, next channel
+            if (i < 0) {
+                select(queue[0].channel);
+                continue;
+            }
+
+            void (*fn)(void) = queue[i].run;
+
+            jobs--;
+            for (uint8_t k = i; k < jobs; k++) queue[k] = queue[k + 1];
+
+            fn();
+        }
+    }
+
+protected:
+    uint8_t channel;
+    BusJob queue[MAX_JOBS];
+    uint8_t jobs;
+
+    int8_t find(uint8_t ch) {
+        for (uint8_t i = 0; i < jobs; i++)
+            if (queue[i].channel == ch) return i;
+        return -1;
+    }
+};
+
+#endif
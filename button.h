@@ -0,0 +1,142 @@
+// Button - Angelo Z. (2025)
+
+/*
+  Push button sampled by the timer interrupt, 1 kHz.
+
+  The pin goes through an integrator: every sample pressed counts up,
+  every sample released counts down, and the state changes only at
+  the ends. A bounce of a few samples never gets there.
+
+      pin     ‾‾‾|_|‾|___________________|‾|_|‾‾‾‾‾‾‾
+      count   0  1 0 1 2 3 4 5 5 ....  5 4 3 2 1 0
+      state   released     pressed ........    released
+
+  Then the gestures, each one queued as an event with the micros() of
+  the sample that decided it:
+
+      IDLE --press--> DOWN --release--> EV_CLICK, CLICKED
+                        \--longPress--> EV_HOLD, HELD --repeat--> EV_REPEAT
+      CLICKED --press within doubleClick--> DOWN, the click after is EV_DOUBLE
+
+  A click is sent on the release, not after the double click window:
+  a double click is a click followed by EV_DOUBLE. doubleClick 0 turns
+  it off, repeat 0 sends EV_HOLD only.
+*/
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <Arduino.h>
+#include "events.h"
+
+#define DEBOUNCE_SAMPLES  5     // At 1 kHz, ms
+#define DOUBLE_CLICK_MS   250
+#define REPEAT_MS         200
+
+
+class DebouncedButton {
+public:
+    // A gesture was queued, read by the main loop without a lock
+    volatile uint8_t gestures;
+
+    DebouncedButton(uint16_t longPressMs) {
+        configure(DOUBLE_CLICK_MS, longPressMs, REPEAT_MS);
+        count = 0;
+        pressed = false;
+        state = BTN_IDLE;
+        second = false;
+        since = 0;
+        gestures = 0;
+    }
+
+    // Times in ms
+    void configure(uint16_t doubleClickMs, uint16_t longPressMs, uint16_t repeatMs) {
+        doubleClick = doubleClickMs * 1000UL;
+        longPress = longPressMs * 1000UL;
+        repeat = repeatMs * 1000UL;
+    }
+
+    // Released and settled, no gesture waiting for time: the sampling
+    // can stop until the next edge
+    boolean idle() {
+        return state == BTN_IDLE && count == 0;
+    }
+
+    /*
+    =====================
+     void sample
+    =====================
+    */
+    // Interrupt context. pin true when the button is down.
+    void sample(boolean pin, unsigned long now, EventQueue &events) {
+        // Integrator
+        if (pin) {
+            if (count < DEBOUNCE_SAMPLES && ++count == DEBOUNCE_SAMPLES && !pressed)
+                press(now, events);
+        } else {
+            if (count > 0 && --count == 0 && pressed)
+                release(now, events);
+        }
+
+        // Time driven gestures
+        switch (state) {
+            case BTN_DOWN:
+                if (now - since >= longPress) {
+                    state = BTN_HELD;
+                    since = now;
+                    repeats = 0;
+                    send(events, EV_HOLD, 0, now);
+                }
+                break;
+            case BTN_HELD:
+                if (repeat && now - since >= repeat) {
+                    since += repeat;
+                    if (repeats < 127) repeats++;
+                    send(events, EV_REPEAT, repeats, now);
+                }
+                break;
+            case BTN_CLICKED:
+                if (now - since >= doubleClick) state = BTN_IDLE;
+                break;
+        }
+    }
+
+protected:
+    enum { BTN_IDLE, BTN_DOWN, BTN_HELD, BTN_CLICKED };
+
+    uint8_t count;              // Integrator, 0..DEBOUNCE_SAMPLES
+    boolean pressed;            // Debounced
+    uint8_t state;
+    boolean second;             // Second press of a double click
+    int8_t repeats;
+    unsigned long since;        // micros() of the last edge or repeat
+    unsigned long doubleClick, longPress, repeat;
+
+    void press(unsigned long now, EventQueue &events) {
+        pressed = true;
+        second = state == BTN_CLICKED;
+        state = BTN_DOWN;
+        since = now;
+        send(events, EV_PRESS, 0, now);
+    }
+
+    void release(unsigned long now, EventQueue &events) {
+        pressed = false;
+        send(events, EV_RELEASE, 0, now);
+
+        if (state == BTN_DOWN) {
+            send(events, second ? EV_DOUBLE : EV_CLICK, 0, now);
+            // After a double click the next one starts over
+            state = doubleClick && !second ? BTN_CLICKED : BTN_IDLE;
+            since = now;
+        } else {
+            state = BTN_IDLE;
+        }
+    }
+
+    void send(EventQueue &events, uint8_t type, int8_t value, unsigned long now) {
+        events.push(type, value, now);
+        gestures++;
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+// Encoder - Angelo Z. (2025)
+
+/*
+  Quadrature decoder driven by the pin change interrupts of A and B
+  (INT0/INT1, pins 2 and 3): it runs only when the encoder moves.
+
+  Each edge indexes a table with the previous and the new state of
+  the two pins:
+
+      state  AB   00 -> 01 -> 11 -> 10 -> 00   +1 each
+                  00 <- 01 <- 11 <- 10 <- 00   -1 each
+
+      index  = previous << 2 | new
+      step   = +1, -1, or 0 for no change and for the jumps of two
+               states (an edge lost, the direction is unknown)
+
+  A bounce goes forth and back between two states and cancels out.
+  Every StepsPerNotch steps in the same direction are one detent,
+  queued with its own micros(): the acceleration measures the speed
+  between detents, not between polls.
+
+  If the queue is full the detents are kept and go with the next one,
+  or are taken by the main loop once it has emptied the queue. A
+  spin of thousands of detents while the loop is busy is kept whole;
+  past 32766 they are dropped and counted in events.dropped.
+*/
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <Arduino.h>
+#include "events.h"
+
+const int8_t quadratureSteps[16] PROGMEM = {
+//  new  00  01  10  11      previous
+          0, +1, -1,  0,  // 00
+         -1,  0,  0, +1,  // 01
+         +1,  0,  0, -1,  // 10
+          0, -1, +1,  0   // 11
+};
+
+
+class QuadratureDecoder {
+public:
+    // Statistics
+    volatile uint16_t edges, invalid;
+
+    QuadratureDecoder(uint8_t stepsPerNotch) {
+        steps = stepsPerNotch;
+        state = 0;
+        acc = 0;
+        pending = 0;
+        edges = invalid = 0;
+    }
+
+    // Pins as they are now, before the interrupts are attached
+    void begin(uint8_t ab) {
+        state = ab & 3;
+        acc = 0;
+    }
+
+    /*
+    =====================
+     void update
+    =====================
+    */
+    // Interrupt context. ab = A << 1 | B.
+    void update(uint8_t ab, unsigned long now, EventQueue &events) {
+        uint8_t index = state << 2 | (ab & 3);
+
+        edges++;
+        if (index == 0x3 || index == 0x6 || index == 0x9 || index == 0xc)
+            invalid++;
+
+        state = ab & 3;
+        acc += (int8_t) pgm_read_byte(&quadratureSteps[index]);
+
+        if (acc >= (int8_t) steps) {
+            acc -= steps;
+            detent(1, now, events);
+        } else if (acc <= -(int8_t) steps) {
+            acc += steps;
+            detent(-1, now, events);
+        }
+    }
+
+    // Main loop, after the queue is empty: the detents that didn't fit
+    int16_t take() {
+        uint8_t sreg = SREG;
+        int16_t n;
+
+        cli();
+        n = pending;
+        pending = 0;
+        SREG = sreg;
+
+        return n;
+    }
+
+protected:
+    uint8_t steps;
+    uint8_t state;      // Last AB
+    int8_t acc;         // Steps since the last detent
+    int16_t pending;    // Detents the queue had no room for
+
+    void detent(int8_t dir, unsigned long now, EventQueue &events) {
+        int16_t n = pending + dir;
+
+        // An event holds a byte of detents, the rest waits for take()
+        if (!events.full() && n >= -128 && n <= 127) {
+            events.push(EV_DETENT, n, now);
+            pending = 0;
+        } else if (n > -32767 && n < 32767) {
+            pending = n;
+        } else {
+            // Lost: counted with the events
+            events.dropped++;
+        }
+    }
+};
+
+#endif
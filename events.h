@@ -0,0 +1,115 @@
+// Events - Angelo Z. (2025)
+
+/*
+  Input events from the interrupts to the main loop.
+
+  Ring buffer with one consumer (loop) and two producers: timerIsr
+  for the button and encoderIsr on INT0 and INT1 for the detents.
+  push() is not reentrant and doesn't have to be: AVR interrupts don't
+  nest, the I bit stays clear until reti, so one push runs at a time.
+  A handler that enabled interrupts (sei(), ISR_NOBLOCK) would break
+  this. REPLAY builds have a single producer, replayInput() in the
+  loop, and both handlers return at once.
+
+  The producers only move head, the consumer only moves tail, and both
+  are one byte wide, so no lock is needed on the AVR.
+
+        tail            head
+         v               v
+      [ ev | ev | ev |    |    |    |    |    ]
+
+  When the buffer is full the new event is dropped and counted. The
+  detents that find it full wait in the decoder, see encoder.h: the
+  buffer holds only the gestures of a frame.
+*/
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 8  // Power of two, 6 bytes each
+#endif
+
+// Keep the compiler from moving buffer accesses across the index update
+#define barrier() asm volatile("" ::: "memory")
+
+typedef enum {
+    EV_DETENT,      // value = signed detents
+    EV_PRESS,
+    EV_RELEASE,
+    EV_CLICK,       // Released before BUTTON_HOLDTIME
+    EV_HOLD,        // Still pressed after BUTTON_HOLDTIME
+    EV_DOUBLE,      // Second click, instead of EV_CLICK
+    EV_REPEAT       // Held, value = repeats so far
+} EventType;
+
+typedef struct {
+    uint8_t type;
+    int8_t value;
+    unsigned long time;  // micros()
+} InputEvent;
+
+
+class EventQueue {
+public:
+    volatile uint16_t dropped;
+
+    EventQueue() {
+        head = tail = 0;
+        dropped = 0;
+    }
+
+    /*
+    =====================
+     boolean push
+    =====================
+    */
+    // Producer side, interrupt context only.
+    boolean push(uint8_t type, int8_t value, unsigned long time) {
+        uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+
+        if (next == tail) {
+            dropped++;
+            return false;
+        }
+
+        buf[head].type = type;
+        buf[head].value = value;
+        buf[head].time = time;
+        barrier();
+        head = next;
+
+        return true;
+    }
+
+    /*
+    =====================
+     boolean pop
+    =====================
+    */
+    // Consumer side, main loop only.
+    boolean pop(InputEvent &ev) {
+        if (tail == head) return false;
+
+        ev = buf[tail];
+        barrier();
+        tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+
+        return true;
+    }
+
+    boolean empty() {
+        return tail == head;
+    }
+
+    boolean full() {
+        return ((head + 1) & (EVENT_QUEUE_SIZE - 1)) == tail;
+    }
+
+protected:
+    InputEvent buf[EVENT_QUEUE_SIZE];
+    volatile uint8_t head, tail;
+};
+
+#endif
@@ -0,0 +1,147 @@
+// Format - Angelo Z. (2025)
+
+/*
+  Values as text, without sprintf.
+
+  A format is one byte of flash in the item:
+
+      bit  7 6 5 4   3   2       1 0
+           unit      -   group   decimals
+
+      12345, FMT_DECIMALS(2) | FMT_UNIT(UNIT_V)   ->  "123.45V"
+      160000000, FMT_GROUP                        ->  "160,000,000"
+
+  FMT_ONOFF and FMT_YESNO print the value as a switch.
+  The width in pixels comes back with the text, so there is no strlen()
+  to align it. ValueCache keeps the text of the last values drawn, by
+  item id, until the value changes. The format of an item is in flash
+  and never changes, so the id and the value are the whole key.
+*/
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+
+#define FORMAT_SIZE   17  // Sign, 10 digits, 3 commas or point and 2, unit, '\0'
+#define FORMAT_SLOTS  4   // A screen of rows, the open item is one of them
+
+#define FMT_DECIMALS(n)  (n)        // 0..3 digits after the point
+#define FMT_GROUP        4          // Commas between thousands
+#define FMT_UNIT(u)      ((u) << 4)
+#define FMT_ONOFF        0xfe
+#define FMT_YESNO        0xff
+
+enum { UNIT_NONE, UNIT_HZ, UNIT_MS, UNIT_PERCENT, UNIT_V, N_UNITS };
+
+const char unitNone[] PROGMEM = "";
+const char unitHz[] PROGMEM = "Hz";
+const char unitMs[] PROGMEM = "ms";
+const char unitPercent[] PROGMEM = "%";
+const char unitV[] PROGMEM = "V";
+
+const char *const units[N_UNITS] PROGMEM = {
+    unitNone, unitHz, unitMs, unitPercent, unitV
+};
+
+
+/*
+=====================
+ uint8_t formatValue
+=====================
+*/
+// Write v in buf (FORMAT_SIZE), return its width in pixels
+inline uint8_t formatValue(char *buf, long v, uint8_t format, uint8_t fontW) {
+    char tmp[FORMAT_SIZE];
+    uint8_t n = 0, len = 0, i = 0;
+    uint8_t dec = format & 3;
+    unsigned long u = v < 0 ? -(unsigned long) v : v;
+
+    if (format == FMT_ONOFF || format == FMT_YESNO) {
+        const char *s = format == FMT_ONOFF ? (v ? "ON" : "OFF")
+                                            : (v ? "YES" : "NO");
+        while ((buf[len] = s[len]) != '\0') len++;
+        return len * fontW;
+    }
+
+    // Backwards, from the last digit
+    do {
+        if (dec && i == dec) tmp[n++] = '.';
+        else if ((format & FMT_GROUP) && i > dec && (i - dec) % 3 == 0)
+            tmp[n++] = ',';
+        tmp[n++] = '0' + u % 10;
+        u /= 10;
+        i++;
+    } while (u || i <= dec);
+
+    if (v < 0) buf[len++] = '-';
+    while (n) buf[len++] = tmp[--n];
+
+    // Unit
+    const char *unit = (const char *) pgm_read_ptr(&units[(format >> 4) % N_UNITS]);
+    while ((buf[len] = pgm_read_byte(unit++)) != '\0') len++;
+
+    return len * fontW;
+}
+
+
+typedef struct {
+    uint8_t id;         // 0xff = free
+    uint8_t width;      // Pixels
+    uint8_t used;       // Last use, for the LRU
+    long val;
+    char text[FORMAT_SIZE];
+} FormatSlot;
+
+
+class ValueCache {
+public:
+    // Statistics
+    unsigned long hits, misses;
+
+    ValueCache() {
+        for (uint8_t i = 0; i < FORMAT_SLOTS; i++) slots[i].id = 0xff;
+        tick = 0;
+        hits = misses = 0;
+    }
+
+    /*
+    =====================
+     const char *get
+    =====================
+    */
+    // Text of the value of item id. Formatted again only when the
+    // value changed.
+    const char *get(uint8_t id, long val, uint8_t format, uint8_t fontW,
+                    uint8_t &width) {
+        FormatSlot *s = NULL;
+
+        for (uint8_t i = 0; i < FORMAT_SLOTS; i++) {
+            FormatSlot *c = &slots[i];
+
+            if (c->id == id) { s = c; break; }
+            // Free or least recently used
+            if (s == NULL || c->id == 0xff
+                          || (s->id != 0xff && (uint8_t) (tick - c->used) > (uint8_t) (tick - s->used)))
+                s = c;
+        }
+
+        if (s->id == id && s->val == val) {
+            hits++;
+        } else {
+            misses++;
+            s->id = id;
+            s->val = val;
+            s->width = formatValue(s->text, val, format, fontW);
+        }
+
+        s->used = ++tick;
+        width = s->width;
+        return s->text;
+    }
+
+protected:
+    FormatSlot slots[FORMAT_SLOTS];
+    uint8_t tick;
+};
+
+#endif
@@ -0,0 +1,381 @@
+// Framebuffer - Angelo Z. (2025)
+
+/*
+  OLED with dirty region tracking.
+
+  OLED::update() sends the whole 1 KB buffer (8 pages x 128 columns)
+  on every call. PagedOLED remembers, for each page, up to two ranges
+  of columns touched by the drawing calls and update() sends only those
+  bytes using the SSD1306 column/page addressing.
+
+      page 0  |....######..........|   lo = 4, hi = 9
+      page 1  |....................|   clean
+      page 2  |##################..|   lo = 0, hi = 17
+      page 3  |###.............##..|   lo = 0, hi = 2, lo2 = 16, hi2 = 17
+
+  Two ranges further apart than OLED_GAP stay apart: the marker on the
+  left and the scrollbar on the right don't send the whole row.
+
+  The panel must be in horizontal addressing mode (set in begin()).
+*/
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <OLED_I2C.h>
+
+#define OLED_ADDR   0x3C
+#define OLED_COLS   128
+#define OLED_ROWS   64
+#define OLED_PAGES  (OLED_ROWS / 8)
+#define OLED_CHUNK  16 // Data bytes for each Wire transaction
+
+#define OLED_GAP    10 // Columns, about the cost of one more window
+
+#define CLEAN_PAGE  0xff
+
+// fillRect() modes
+#define FILL_SET    0
+#define FILL_CLEAR  1
+#define FILL_INVERT 2
+
+
+class PagedOLED : public OLED {
+public:
+    // Statistics
+    unsigned long bytesSent;
+    unsigned long transactions;
+    uint16_t updates;
+    unsigned long glyphs;   // Characters rasterized
+
+    PagedOLED(uint8_t data_pin, uint8_t sclk_pin) : OLED(data_pin, sclk_pin) {
+        bytesSent = 0;
+        transactions = 0;
+        updates = 0;
+        glyphs = 0;
+        markAll();
+    }
+
+    void begin(uint8_t type) {
+        OLED::begin(type);
+        // Horizontal addressing: the column pointer wraps on the next
+        // page inside the window set by update()
+        command(0x20);
+        command(0x00);
+        markAll();
+    }
+
+    /*
+    =====================
+     Drawing
+    =====================
+    */
+    // Same as OLED, but the touched area is recorded.
+    void clrScr() {
+        // Only the pages with something on them have to be erased
+        // on the panel.
+        for (uint8_t p = 0; p < OLED_PAGES; p++) {
+            uint8_t *row = scrbuf + p * OLED_COLS;
+            int lo = 0, hi = OLED_COLS - 1;
+
+            while (lo <= hi && row[lo] == 0) lo++;
+            while (hi >= lo && row[hi] == 0) hi--;
+            if (lo <= hi) markPage(p, lo, hi);
+        }
+        OLED::clrScr();
+    }
+
+    void fillScr() {
+        OLED::fillScr();
+        markAll();
+    }
+
+    void setPixel(uint16_t x, uint16_t y) {
+        OLED::setPixel(x, y);
+        markDirty(x, y, x, y);
+    }
+
+    void clrPixel(uint16_t x, uint16_t y) {
+        OLED::clrPixel(x, y);
+        markDirty(x, y, x, y);
+    }
+
+    void print(const char *st, int x, int y) {
+        int w = strlen(st) * cfont.x_size;
+
+        if (x == RIGHT) x = OLED_COLS - w;
+        if (x == CENTER) x = (OLED_COLS - w) / 2;
+
+        OLED::print((char *) st, x, y);
+        markDirty(x, y, x + w - 1, y + cfont.y_size - 1);
+        glyphs += strlen(st);
+    }
+
+    void drawLine(int x1, int y1, int x2, int y2) {
+        OLED::drawLine(x1, y1, x2, y2);
+        markDirty(min(x1, x2), min(y1, y2), max(x1, x2), max(y1, y2));
+    }
+
+    void drawRect(int x1, int y1, int x2, int y2) {
+        OLED::drawRect(x1, y1, x2, y2);
+        markDirty(min(x1, x2), min(y1, y2), max(x1, x2), max(y1, y2));
+    }
+
+    /*
+    =====================
+     void fillRect
+    =====================
+    */
+    // Fill straight into the buffer a byte (8 rows) at a time. Whole
+    // pages are a memset, the first and last page use a bit mask.
+    //
+    //   y = 4, h = 16     page 0  11110000  mask
+    //                     page 1  11111111  memset
+    //                     page 2  00001111  mask
+    void fillRect(int x, int y, int w, int h, uint8_t mode = FILL_SET) {
+        if (x < 0) { w += x; x = 0; }
+        if (y < 0) { h += y; y = 0; }
+        if (x + w > OLED_COLS) w = OLED_COLS - x;
+        if (y + h > OLED_ROWS) h = OLED_ROWS - y;
+        if (w <= 0 || h <= 0) return;
+
+        int y2 = y + h - 1;
+
+        for (uint8_t p = y / 8; p <= y2 / 8; p++) {
+            uint8_t *row = scrbuf + p * OLED_COLS + x;
+            uint8_t mask = 0xff;
+
+            if (p == y / 8) mask &= 0xff << (y % 8);
+            if (p == y2 / 8) mask &= 0xff >> (7 - y2 % 8);
+
+            if (mask == 0xff && mode != FILL_INVERT) {
+                memset(row, mode == FILL_SET ? 0xff : 0x00, w);
+                continue;
+            }
+
+            for (int i = 0; i < w; i++) {
+                if (mode == FILL_SET) row[i] |= mask;
+                else if (mode == FILL_CLEAR) row[i] &= ~mask;
+                else row[i] ^= mask;
+            }
+        }
+
+        markDirty(x, y, x + w - 1, y2);
+    }
+
+    /*
+    =====================
+     void blit
+    =====================
+    */
+    // Copy columns of an 8 pixel high text at any y. The cell is
+    // cleared and the columns ORed in, or for inverted text the cell is
+    // set and the columns XORed: the same bitmap serves both. A text
+    // partly off the screen is clipped.
+    //
+    //   y = 4     page 0  cols << 4   (rows 4..7)
+    //             page 1  cols >> 4   (rows 0..3)
+    void blit(const uint8_t *cols, int len, int x, int y, boolean invert) {
+        if (y <= -8 || y >= OLED_ROWS) return;
+
+        int p = (y + 8) / 8 - 1;    // -1 when above the screen
+        uint8_t s = y - p * 8;
+        uint16_t mask = 0xff << s;
+        boolean top = p >= 0, bottom = s && p + 1 < OLED_PAGES;
+        int x1 = max(x, 0), x2 = min(x + len, OLED_COLS) - 1;
+
+        for (int c = x1; c <= x2; c++) {
+            uint16_t b = cols[c - x] << s;
+            uint8_t *up = scrbuf + p * OLED_COLS + c;      // Valid if top
+            uint8_t *down = scrbuf + (p + 1) * OLED_COLS + c;
+
+            if (invert) {
+                if (top) *up = (*up | mask) ^ b;
+                if (bottom) *down = (*down | mask >> 8) ^ b >> 8;
+            } else {
+                if (top) *up = (*up & ~mask) | b;
+                if (bottom) *down = (*down & ~(mask >> 8)) | b >> 8;
+            }
+        }
+
+        markDirty(x1, y, x2, y + 7);
+    }
+
+    // The current font, for the text cache
+    const uint8_t *fontData() { return cfont.font; }
+    uint8_t fontWidth()       { return cfont.x_size; }
+    uint8_t fontHeight()      { return cfont.y_size; }
+    uint8_t fontOffset()      { return cfont.offset; }
+    boolean isInverted()      { return cfont.inverted; }
+
+    /*
+    =====================
+     Dirty region
+    =====================
+    */
+    void markDirty(int x1, int y1, int x2, int y2) {
+        if (x2 < 0 || y2 < 0 || x1 >= OLED_COLS || y1 >= OLED_ROWS)
+            return;
+
+        x1 = max(x1, 0);  y1 = max(y1, 0);
+        x2 = min(x2, OLED_COLS - 1);  y2 = min(y2, OLED_ROWS - 1);
+
+        for (uint8_t p = y1 / 8; p <= y2 / 8; p++)
+            markPage(p, x1, x2);
+    }
+
+    void markAll() {
+        for (uint8_t p = 0; p < OLED_PAGES; p++) {
+            lo[p] = 0;
+            hi[p] = OLED_COLS - 1;
+            lo2[p] = CLEAN_PAGE;
+            hi2[p] = 0;
+        }
+    }
+
+    boolean isDirty() {
+        for (uint8_t p = 0; p < OLED_PAGES; p++)
+            if (lo[p] != CLEAN_PAGE) return true;
+        return false;
+    }
+
+    /*
+    =====================
+     void update
+    =====================
+    */
+    // Send only the dirty columns of each dirty page. Consecutive pages
+    // with the same column ranges share the addressing windows.
+    void update() {
+        uint8_t p = 0;
+
+        while (p < OLED_PAGES) {
+            if (lo[p] == CLEAN_PAGE) { p++; continue; }
+
+            uint8_t last = p;
+            while (last + 1 < OLED_PAGES && lo[last + 1] == lo[p]
+                                         && hi[last + 1] == hi[p]
+                                         && lo2[last + 1] == lo2[p]
+                                         && hi2[last + 1] == hi2[p])
+                last++;
+
+            sendWindow(p, last, lo[p], hi[p]);
+            if (lo2[p] != CLEAN_PAGE) sendWindow(p, last, lo2[p], hi2[p]);
+
+            for (uint8_t q = p; q <= last; q++) {
+                lo[q] = lo2[q] = CLEAN_PAGE;
+                hi[q] = hi2[q] = 0;
+            }
+            p = last + 1;
+        }
+
+        updates++;
+    }
+
+    void updateAll() {
+        markAll();
+        update();
+    }
+
+    /*
+    =====================
+     void dump
+    =====================
+    */
+    // The buffer as a binary PBM image (P4): rows of 16 bytes, most
+    // significant bit on the left, 1 = lit.
+    void dump(Print &out) {
+        out.print("P4\n128 64\n");
+
+        for (uint8_t y = 0; y < OLED_ROWS; y++) {
+            uint8_t *page = scrbuf + (y / 8) * OLED_COLS;
+            uint8_t bit = 1 << (y % 8);
+
+            for (uint8_t x = 0; x < OLED_COLS; x += 8) {
+                uint8_t b = 0;
+                for (uint8_t i = 0; i < 8; i++)
+                    if (page[x + i] & bit) b |= 0x80 >> i;
+                out.write(b);
+            }
+        }
+    }
+
+protected:
+    uint8_t lo[OLED_PAGES], hi[OLED_PAGES];
+    uint8_t lo2[OLED_PAGES], hi2[OLED_PAGES];  // Second range
+
+    boolean near(uint8_t x1, uint8_t x2, uint8_t l, uint8_t h) {
+        return x1 <= h + OLED_GAP && x2 + OLED_GAP >= l;
+    }
+
+    void markPage(uint8_t p, uint8_t x1, uint8_t x2) {
+        if (lo[p] == CLEAN_PAGE) {
+            lo[p] = x1;
+            hi[p] = x2;
+        } else if (near(x1, x2, lo[p], hi[p])) {
+            lo[p] = min(lo[p], x1);
+            hi[p] = max(hi[p], x2);
+        } else if (lo2[p] == CLEAN_PAGE) {
+            lo2[p] = x1;
+            hi2[p] = x2;
+            return;
+        } else {
+            // A third range: the second one takes it, whatever the gap
+            lo2[p] = min(lo2[p], x1);
+            hi2[p] = max(hi2[p], x2);
+        }
+
+        // The first range has grown up to the second one
+        if (lo2[p] != CLEAN_PAGE && near(lo2[p], hi2[p], lo[p], hi[p])) {
+            lo[p] = min(lo[p], lo2[p]);
+            hi[p] = max(hi[p], hi2[p]);
+            lo2[p] = CLEAN_PAGE;
+            hi2[p] = 0;
+        }
+    }
+
+    void command(uint8_t c) {
+        Wire.beginTransmission(OLED_ADDR);
+        Wire.write(0x00);
+        Wire.write(c);
+        Wire.endTransmission();
+        bytesSent += 3;
+        transactions++;
+    }
+
+    void sendWindow(uint8_t p1, uint8_t p2, uint8_t x1, uint8_t x2) {
+        Wire.beginTransmission(OLED_ADDR);
+        Wire.write(0x00);   // Command stream
+        Wire.write(0x21);   // Column address
+        Wire.write(x1);
+        Wire.write(x2);
+        Wire.write(0x22);   // Page address
+        Wire.write(p1);
+        Wire.write(p2);
+        Wire.endTransmission();
+        bytesSent += 8;
+        transactions++;
+
+        for (uint8_t p = p1; p <= p2; p++) {
+            uint8_t *data = scrbuf + p * OLED_COLS + x1;
+            int len = x2 - x1 + 1;
+
+            while (len > 0) {
+                uint8_t n = min(len, OLED_CHUNK);
+
+                Wire.beginTransmission(OLED_ADDR);
+                Wire.write(0x40);   // Data stream
+                Wire.write(data, n);
+                Wire.endTransmission();
+                bytesSent += n + 2;
+                transactions++;
+
+                data += n;
+                len -= n;
+            }
+        }
+    }
+};
+
+#endif
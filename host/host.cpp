@@ -0,0 +1,600 @@
+// Host - Angelo Z. (2025)
+
+/*
+  Virtual clock, pins, interrupts and the I2C devices, see host.h.
+*/
+#include <Arduino.h>
+#include <Wire.h>
+#include <TimerOne.h>
+#include "host.h"
+
+void setup();
+void loop();
+
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+
+HardwareSerial Serial;
+TwoWire Wire;
+TimerOne Timer1;
+
+volatile uint8_t PINB = 0xff, PIND = 0xff, PCICR = 0, PCMSK0 = 0;
+// Interrupts on before setup(), as on the board
+volatile uint8_t SREG = 0x80;
+
+unsigned long hostTones = 0;
+
+static unsigned long long nowNs = 0;
+
+
+/* ===================== Interrupts ===================== */
+// Raised and waiting, in the priority of the AVR vectors
+enum { IRQ_INT0, IRQ_INT1, IRQ_PCINT0, IRQ_TIMER1, N_IRQ };
+
+static boolean raised[N_IRQ];
+static boolean inIsr = false;
+static void (*intIsr[2])(void);
+static int intMode[2];
+
+static void service() {
+    for (;;) {
+        uint8_t i;
+
+        if (!(SREG & 0x80) || inIsr) return;
+        for (i = 0; i < N_IRQ && !raised[i]; i++) ;
+        if (i == N_IRQ) return;
+
+        raised[i] = false;
+        inIsr = true;
+        SREG &= ~0x80;
+
+        switch (i) {
+            case IRQ_INT0:   if (intIsr[0]) intIsr[0](); break;
+            case IRQ_INT1:   if (intIsr[1]) intIsr[1](); break;
+            case IRQ_PCINT0: if (PCINT0_vect) PCINT0_vect(); break;
+            case IRQ_TIMER1: if (Timer1.isr) Timer1.isr(); break;
+        }
+
+        SREG |= 0x80;
+        inIsr = false;
+    }
+}
+
+void sei() {
+    SREG |= 0x80;
+    service();
+}
+
+void attachInterrupt(uint8_t num, void (*isr)(void), int mode) {
+    if (num > 1) return;
+    intIsr[num] = isr;
+    intMode[num] = mode;
+}
+
+void detachInterrupt(uint8_t num) {
+    if (num < 2) intIsr[num] = NULL;
+}
+
+
+/* ===================== Time ===================== */
+static void advanceNs(unsigned long long ns) {
+    unsigned long long end = nowNs + ns;
+
+    service();
+    while (Timer1.running && Timer1.isr
+                          && Timer1.next * 1000ULL <= end) {
+        if (Timer1.next * 1000ULL > nowNs) nowNs = Timer1.next * 1000ULL;
+        Timer1.next += Timer1.period;
+        raised[IRQ_TIMER1] = true;
+        service();
+    }
+    nowNs = end;
+    service();
+}
+
+void hostAdvance(unsigned long us) {
+    advanceNs(us * 1000ULL);
+}
+
+unsigned long micros() { return nowNs / 1000; }
+unsigned long millis() { return nowNs / 1000000; }
+void delay(unsigned long ms) { hostAdvance(ms * 1000); }
+void delayMicroseconds(unsigned int us) { hostAdvance(us); }
+
+void hostRun(unsigned long ms) {
+    unsigned long end = micros() + ms * 1000;
+
+    while ((long) (end - micros()) > 0) {
+        loop();
+        hostAdvance(HOST_LOOP_US);
+    }
+}
+
+
+/* ===================== Pins ===================== */
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t level) {}
+
+int digitalRead(uint8_t pin) {
+    if (pin < 8) return PIND >> pin & 1;
+    if (pin < 14) return PINB >> (pin - 8) & 1;
+    return HIGH;
+}
+
+void hostPin(uint8_t pin, uint8_t level) {
+    uint8_t old = digitalRead(pin);
+
+    if (pin < 8) PIND = level ? PIND | 1 << pin : PIND & ~(1 << pin);
+    else if (pin < 14) PINB = level ? PINB | 1 << (pin - 8) : PINB & ~(1 << (pin - 8));
+    if (old == level) return;
+
+    if (pin == 2 || pin == 3) {
+        uint8_t n = pin - 2;
+
+        if (intIsr[n] && (intMode[n] == CHANGE
+                          || (intMode[n] == RISING && level)
+                          || (intMode[n] == FALLING && !level)))
+            raised[IRQ_INT0 + n] = true;
+    } else if (pin >= 8 && pin < 14) {
+        if ((PCICR & 1 << PCIE0) && (PCMSK0 & 1 << (pin - 8)))
+            raised[IRQ_PCINT0] = true;
+    }
+    service();
+}
+
+// AB in the +1 direction, A on pin 2 and B on pin 3
+static const uint8_t gray[4] = { 0, 1, 3, 2 };
+static uint8_t encoderPos = 2;  // AB = 11, the pull-ups
+
+void hostTurn(int16_t detents, unsigned long usPerDetent, uint8_t bounces) {
+    int8_t dir = detents < 0 ? -1 : 1;
+    unsigned long edge = usPerDetent / 4;
+
+    for (long s = 0; s < 4L * abs(detents); s++) {
+        uint8_t from = gray[encoderPos & 3];
+        uint8_t to = gray[(encoderPos += dir) & 3];
+        uint8_t pin = (from ^ to) & 2 ? 2 : 3;
+        uint8_t level = pin == 2 ? to >> 1 : to & 1;
+
+        for (uint8_t b = 0; b < bounces; b++) {
+            hostPin(pin, level);
+            hostAdvance(5);
+            hostPin(pin, !level);
+            hostAdvance(5);
+        }
+        hostPin(pin, level);
+        hostAdvance(edge);
+    }
+}
+
+void hostButton(boolean down, uint8_t bounces) {
+    for (uint8_t b = 0; b < bounces; b++) {
+        hostPin(8, down ? LOW : HIGH);
+        hostAdvance(300);
+        hostPin(8, down ? HIGH : LOW);
+        hostAdvance(300);
+    }
+    hostPin(8, down ? LOW : HIGH);
+}
+
+void hostClick() {
+    hostButton(true, 2);
+    hostRun(100);
+    hostButton(false, 2);
+    hostRun(400);
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+    hostTones++;
+}
+
+void noTone(uint8_t pin) {}
+
+
+/* ===================== Devices ===================== */
+class Device {
+public:
+    uint8_t address, channel;
+
+    Device(uint8_t a, uint8_t ch) : address(a), channel(ch) {}
+    virtual ~Device() {}
+    virtual void reset() {}
+    // false = not acknowledged
+    virtual boolean write(const uint8_t *data, uint8_t n) = 0;
+    virtual boolean read(uint8_t *data, uint8_t n) { return false; }
+};
+
+
+/*
+=====================
+ Ssd1306
+=====================
+*/
+// Command and data streams, the three addressing modes
+class Ssd1306 : public Device {
+public:
+    uint8_t gram[1024];
+    boolean inverted;
+
+    Ssd1306() : Device(0x3C, 0) { reset(); }
+
+    void reset() {
+        memset(gram, 0, sizeof(gram));
+        inverted = false;
+        mode = 2;
+        colStart = col = 0;
+        colEnd = 127;
+        pageStart = page = 0;
+        pageEnd = 7;
+        args = 0;
+    }
+
+    boolean write(const uint8_t *d, uint8_t n) {
+        uint8_t i = 0;
+
+        while (i < n) {
+            uint8_t control = d[i++];
+            boolean isData = control & 0x40;
+
+            // Co = 0: the rest of the transaction is of this kind
+            if (!(control & 0x80)) {
+                for (; i < n; i++) isData ? data(d[i]) : command(d[i]);
+            } else if (i < n) {
+                isData ? data(d[i]) : command(d[i]);
+                i++;
+            }
+        }
+        return true;
+    }
+
+protected:
+    uint8_t mode;
+    uint8_t colStart, colEnd, col;
+    uint8_t pageStart, pageEnd, page;
+    uint8_t cmd, args, arg[2], argc;
+
+    void data(uint8_t b) {
+        gram[page * 128 + col] = b;
+
+        if (mode == 0) {
+            if (col++ < colEnd) return;
+            col = colStart;
+            page = page < pageEnd ? page + 1 : pageStart;
+        } else if (mode == 1) {
+            if (page++ < pageEnd) return;
+            page = pageStart;
+            col = col < colEnd ? col + 1 : colStart;
+        } else {
+            if (col++ >= 127) col = colStart;
+        }
+    }
+
+    void command(uint8_t c) {
+        if (args) {
+            arg[argc++] = c;
+            if (--args == 0) apply();
+            return;
+        }
+
+        cmd = c;
+        argc = 0;
+        switch (c) {
+            case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+            case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+                args = 1;
+                break;
+            case 0x21: case 0x22:
+                args = 2;
+                break;
+            case 0xA6: inverted = false; break;
+            case 0xA7: inverted = true; break;
+            default:
+                if (mode != 2) break;
+                if (c >= 0xB0 && c <= 0xB7) page = c & 7;
+                else if (c < 0x10) col = (col & 0xf0) | c;
+                else if (c < 0x20) col = (col & 0x0f) | (c & 0x0f) << 4;
+                break;
+        }
+    }
+
+    void apply() {
+        switch (cmd) {
+            case 0x20: mode = arg[0] & 3; break;
+            case 0x21: colStart = col = arg[0] & 127; colEnd = arg[1] & 127; break;
+            case 0x22: pageStart = page = arg[0] & 7; pageEnd = arg[1] & 7; break;
+        }
+    }
+};
+
+
+/*
+=====================
+ Eeprom24
+=====================
+*/
+// 24LC32: 32 byte pages that roll over, a write cycle of 5 ms with
+// the address not acknowledged, sequential reads.
+class Eeprom24 : public Device {
+public:
+    uint8_t cells[EEPROM_SIZE];
+    long budget;    // Bytes before the power goes, -1 = never
+    boolean dead;
+
+    Eeprom24() : Device(0x50, 1) {
+        memset(cells, 0xff, sizeof(cells));
+        budget = -1;
+        reset();
+    }
+
+    void reset() {
+        pointer = 0;
+        busyUntil = 0;
+        dead = false;
+    }
+
+    boolean write(const uint8_t *d, uint8_t n) {
+        if (micros() < busyUntil) return false;
+        if (n < 2) return true;
+
+        pointer = (d[0] << 8 | d[1]) % EEPROM_SIZE;
+        if (n == 2) return true;
+
+        uint16_t page = pointer & ~31;
+        for (uint8_t i = 2; i < n; i++) {
+            uint16_t at = page | ((pointer + i - 2) & 31);
+
+            if (budget == 0) {
+                cells[at] = ~d[i];
+                dead = true;
+                return true;
+            }
+            if (budget > 0) budget--;
+            cells[at] = d[i];
+        }
+        busyUntil = micros() + EEPROM_CYCLE;
+        return true;
+    }
+
+    boolean read(uint8_t *d, uint8_t n) {
+        if (micros() < busyUntil) return false;
+
+        for (uint8_t i = 0; i < n; i++) {
+            d[i] = cells[pointer];
+            pointer = (pointer + 1) % EEPROM_SIZE;
+        }
+        return true;
+    }
+
+protected:
+    uint16_t pointer;
+    unsigned long busyUntil;
+};
+
+
+/*
+=====================
+ Hd44780
+=====================
+*/
+// The expander outputs: a nibble is taken on the falling edge of E.
+// Starts in 8 bit mode, the function set 0x20 goes to 4 bit.
+class Hd44780 : public Device {
+public:
+    uint8_t ddram[128], cgram[64];
+    uint8_t ac, control, entry;
+    boolean backlight;
+
+    Hd44780() : Device(0x27, 2) { reset(); }
+
+    void reset() {
+        memset(ddram, ' ', sizeof(ddram));
+        memset(cgram, 0, sizeof(cgram));
+        ac = control = 0;
+        entry = 2;
+        cg = fourBit = half = false;
+        last = 0;
+        backlight = false;
+    }
+
+    boolean write(const uint8_t *d, uint8_t n) {
+        for (uint8_t i = 0; i < n; i++) {
+            if ((last & 0x04) && !(d[i] & 0x04)) nibble(last >> 4, last & 1);
+            last = d[i];
+            backlight = last & 0x08;
+        }
+        return true;
+    }
+
+protected:
+    boolean cg, fourBit, half;
+    uint8_t high, last;
+
+    void nibble(uint8_t n, boolean rs) {
+        if (!fourBit) {
+            execute(n << 4, rs);
+        } else if (!half) {
+            high = n;
+            half = true;
+        } else {
+            half = false;
+            execute(high << 4 | n, rs);
+        }
+    }
+
+    void step() {
+        if (entry & 2) {
+            ac++;
+            if (ac == 0x28) ac = 0x40;
+            else if (ac >= 0x68) ac = 0;
+        } else {
+            if (ac == 0) ac = 0x67;
+            else if (ac == 0x40) ac = 0x27;
+            else ac--;
+        }
+    }
+
+    void execute(uint8_t v, boolean rs) {
+        if (rs) {
+            if (cg) { cgram[ac & 63] = v; ac = (ac + 1) & 63; }
+            else { ddram[ac] = v; step(); }
+        } else if (v & 0x80) { ac = v & 0x7f; cg = false; }
+        else if (v & 0x40) { ac = v & 0x3f; cg = true; }
+        else if (v & 0x20) { fourBit = !(v & 0x10); }
+        else if (v & 0x10) { }
+        else if (v & 0x08) { control = v & 7; }
+        else if (v & 0x04) { entry = v & 3; }
+        else if (v & 0x02) { ac = 0; cg = false; }
+        else if (v & 0x01) { memset(ddram, ' ', sizeof(ddram)); ac = 0; cg = false; entry |= 2; }
+    }
+};
+
+
+static Ssd1306 panel;
+static Eeprom24 eeprom;
+static Hd44780 lcdModel;
+static Device *devices[] = { &panel, &eeprom, &lcdModel };
+
+static BusStats stats[128];
+static uint8_t mux = 0;
+
+BusStats &hostBus(uint8_t address) { return stats[address & 127]; }
+void hostBusReset() { memset(stats, 0, sizeof(stats)); }
+uint8_t hostMux() { return mux; }
+
+static Device *find(uint8_t address) {
+    for (uint8_t i = 0; i < sizeof(devices) / sizeof(devices[0]); i++)
+        if (devices[i]->address == address && (mux & 1 << devices[i]->channel))
+            return devices[i];
+    return NULL;
+}
+
+// Start, address and a byte each with its ACK, stop
+static void busTime(uint32_t clock, uint8_t bytes) {
+    advanceNs((9ULL * (bytes + 1) + 2) * 1000000000ULL / clock);
+}
+
+
+/* ===================== Wire ===================== */
+TwoWire::TwoWire() {
+    clock = 100000;
+    address = 0;
+    txLen = rxLen = rxPos = 0;
+    overflow = false;
+}
+
+void TwoWire::beginTransmission(uint8_t a) {
+    address = a;
+    txLen = 0;
+    overflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (txLen == BUFFER_LENGTH) {
+        stats[address & 127].overflows++;
+        overflow = true;
+        return 0;
+    }
+    txBuf[txLen++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n) {
+    size_t sent = 0;
+    for (size_t i = 0; i < n; i++) sent += write(data[i]);
+    return sent;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+    BusStats &s = stats[address & 127];
+    boolean ack = false;
+
+    busTime(clock, txLen);
+    s.transactions++;
+    s.bytes += txLen + 1;
+
+    if (!eeprom.dead) {
+        if (address == 0x70) {
+            if (txLen > 0) mux = txBuf[txLen - 1];
+            ack = true;
+        } else {
+            Device *d = find(address);
+            ack = d && d->write(txBuf, txLen);
+        }
+    }
+
+    if (!ack) s.nacks++;
+    return ack ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t a, uint8_t quantity) {
+    BusStats &s = stats[a & 127];
+    Device *d = eeprom.dead ? NULL : find(a);
+
+    quantity = min(quantity, BUFFER_LENGTH);
+    busTime(clock, quantity);
+    s.transactions++;
+    s.bytes += quantity + 1;
+
+    rxPos = rxLen = 0;
+    if (d && d->read(rxBuf, quantity)) rxLen = quantity;
+    else s.nacks++;
+
+    return rxLen;
+}
+
+
+/* ===================== Device access ===================== */
+const uint8_t *hostPanel() { return panel.gram; }
+boolean hostPanelInverted() { return panel.inverted; }
+
+static const uint8_t *screen = NULL;
+
+void hostScreenBuffer(const uint8_t *buffer) { screen = buffer; }
+
+boolean hostPanelIsBuffer() {
+    return screen && memcmp(panel.gram, screen, sizeof(panel.gram)) == 0;
+}
+
+unsigned long hostPanelBytes() { return stats[panel.address].bytes; }
+
+// P4, as PagedOLED::dump()
+void hostPanelPbm(FILE *out) {
+    fprintf(out, "P4\n128 64\n");
+
+    for (uint8_t y = 0; y < 64; y++) {
+        for (uint8_t x = 0; x < 128; x += 8) {
+            uint8_t b = 0;
+
+            for (uint8_t i = 0; i < 8; i++)
+                if (panel.gram[(y / 8) * 128 + x + i] & 1 << (y % 8))
+                    b |= 0x80 >> i;
+            fputc(panel.inverted ? ~b : b, out);
+        }
+    }
+}
+
+const char *hostLcdLine(uint8_t row) {
+    static char line[17];
+
+    for (uint8_t i = 0; i < 16; i++) {
+        char c = lcdModel.ddram[(row ? 0x40 : 0) + i];
+        line[i] = c >= 0 && c < 8 ? '*' : c;
+    }
+    line[16] = '\0';
+    return line;
+}
+
+uint8_t hostLcdAddress() { return lcdModel.ac; }
+uint8_t hostLcdControl() { return lcdModel.control; }
+
+uint8_t *hostEeprom() { return eeprom.cells; }
+
+void hostPowerCut(long bytes) { eeprom.budget = bytes; }
+boolean hostPowerLost() { return eeprom.dead; }
+
+void hostPowerOn() {
+    eeprom.budget = -1;
+    for (uint8_t i = 0; i < sizeof(devices) / sizeof(devices[0]); i++)
+        if (devices[i] != &eeprom) devices[i]->reset();
+    eeprom.reset();
+    mux = 0;
+}
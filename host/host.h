@@ -0,0 +1,84 @@
+// Host - Angelo Z. (2025)
+
+/*
+  The board around the sketch, on Linux.
+
+      clock   micros() is virtual. hostAdvance() moves it and fires
+              the interrupts on time: Timer1, INT0/INT1 and PCINT0.
+      pins    hostPin() drives an input, its edge raises the interrupt
+      I2C     the TCA9548A at 0x70 and behind it
+
+                  channel 0   SSD1306            0x3C
+                  channel 1   24LC32             0x50
+                  channel 2   HD44780 + PCF8574  0x27
+
+              A device answers only on its own channel. Every
+              transaction takes its time at the Wire clock.
+
+  The interrupts run one at a time with the I flag clear, as on the
+  AVR: one raised meanwhile waits, one flag for each vector, so a
+  second edge before the first is served is lost.
+*/
+#ifndef HOST_H
+#define HOST_H
+
+#include <Arduino.h>
+
+#define HOST_LOOP_US  100   // A pass of loop() with nothing to do
+#define EEPROM_SIZE   4096
+#define EEPROM_CYCLE  5000  // Write cycle, us
+
+typedef struct {
+    unsigned long transactions;
+    unsigned long bytes;        // Address byte included
+    unsigned long nacks;
+    unsigned long overflows;    // Bytes over the Wire buffer
+} BusStats;
+
+/* ===================== Time ===================== */
+void hostAdvance(unsigned long us);
+// loop() for ms of virtual time
+void hostRun(unsigned long ms);
+
+/* ===================== Input ===================== */
+void hostPin(uint8_t pin, uint8_t level);
+// Quadrature edges on pins 2 and 3, each edge bouncing a few times
+void hostTurn(int16_t detents, unsigned long usPerDetent, uint8_t bounces = 0);
+// Button on PB0, low when pressed
+void hostButton(boolean down, uint8_t bounces = 0);
+// A click through loop(): 100 ms down, 400 ms up, two bounces each
+void hostClick();
+
+/* ===================== Devices ===================== */
+BusStats &hostBus(uint8_t address);
+void hostBusReset();
+uint8_t hostMux();
+
+// Panel memory, in the layout of scrbuf
+const uint8_t *hostPanel();
+boolean hostPanelInverted();
+// scrbuf of the OLED stand-in, given by its constructor: after a flush
+// the panel must be the same
+void hostScreenBuffer(const uint8_t *buffer);
+boolean hostPanelIsBuffer();
+// Bytes sent to the panel so far, address bytes included
+unsigned long hostPanelBytes();
+void hostPanelPbm(FILE *out);
+
+// A row of the LCD, 16 characters. The custom characters read as '*'.
+const char *hostLcdLine(uint8_t row);
+uint8_t hostLcdAddress();
+uint8_t hostLcdControl();   // Display, cursor, blink bits
+
+// The eeprom cells, to erase or look at them
+uint8_t *hostEeprom();
+// The power goes after bytes more eeprom bytes are programmed, the
+// byte being programmed is corrupted. -1 = never.
+void hostPowerCut(long bytes);
+boolean hostPowerLost();
+// Devices back, mux on no channel, eeprom idle
+void hostPowerOn();
+
+extern unsigned long hostTones;
+
+#endif
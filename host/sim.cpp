@@ -0,0 +1,193 @@
+// Simulator - Angelo Z. (2025)
+
+/*
+  The sketch on the virtual board.
+
+      sim [-o dir] [-t ms] [script]
+
+  The script moves the pins, a step for each line, ms from the start:
+
+      500   turn 3       three detents, 40 ms each, every edge bounces
+      900   turn -1
+      1000  click        80 ms pressed
+      1500  hold 2500    pressed for 2.5 s
+      # comment
+
+  The edges go in between the passes of loop(), as they would on the
+  board. Without a script it plays the steps of inputScript[].
+
+  Every flush of the OLED is written to dir as frame-NNNN.pbm: the
+  panel memory, what is on the glass, not scrbuf. At the end, the bus
+  traffic of each device.
+*/
+#include "host.h"
+#include "../menu.cpp"
+
+#define MAX_EDGES 8192
+#define DETENT_US 40000UL
+
+typedef struct {
+    unsigned long at;   // us
+    uint8_t pin, level;
+} Edge;
+
+Edge edges[MAX_EDGES];
+uint16_t nEdges = 0;
+uint8_t simAB = 3;      // Pull-ups
+
+const char defaultScript[] =
+    "500 turn 1\n"
+    "1000 click\n"
+    "1500 turn 1\n"
+    "2000 turn -1\n"
+    "2500 turn 2\n"
+    "3000 click\n";
+
+void addEdge(unsigned long at, uint8_t pin, uint8_t level) {
+    if (nEdges == MAX_EDGES) return;
+    edges[nEdges].at = at;
+    edges[nEdges].pin = pin;
+    edges[nEdges].level = level;
+    nEdges++;
+}
+
+// AB in the +1 direction
+const uint8_t simGray[4] = { 0, 1, 3, 2 };
+
+void addTurn(unsigned long at, int detents) {
+    int dir = detents < 0 ? -1 : 1;
+    uint8_t pos = 0;
+
+    while (simGray[pos] != simAB) pos++;
+
+    for (int s = 0; s < 4 * abs(detents); s++) {
+        uint8_t to = simGray[(pos += dir) & 3];
+        uint8_t pin = (simAB ^ to) & 2 ? EncoderPinA : EncoderPinB;
+        uint8_t level = pin == EncoderPinA ? to >> 1 : to & 1;
+
+        // One bounce
+        addEdge(at, pin, level);
+        addEdge(at + 5, pin, !level);
+        addEdge(at + 10, pin, level);
+
+        simAB = to;
+        at += DETENT_US / 4;
+    }
+}
+
+void addPress(unsigned long at, unsigned long ms) {
+    addEdge(at, 8, LOW);
+    addEdge(at + 300, 8, HIGH);
+    addEdge(at + 600, 8, LOW);
+    addEdge(at + ms * 1000, 8, HIGH);
+}
+
+boolean parse(char *line, int number) {
+    unsigned long ms, arg = 0;
+    char what[16];
+    int n = sscanf(line, "%lu %15s %lu", &ms, what, &arg);
+
+    if (line[strspn(line, " \t\r\n")] == '#' || n <= 0) return true;
+    if (n < 2) goto bad;
+
+    if (!strcmp(what, "turn")) addTurn(ms * 1000, (int) (long) arg);
+    else if (!strcmp(what, "click")) addPress(ms * 1000, 80);
+    else if (!strcmp(what, "hold")) addPress(ms * 1000, arg);
+    else if (!strcmp(what, "press")) addEdge(ms * 1000, 8, LOW);
+    else if (!strcmp(what, "release")) addEdge(ms * 1000, 8, HIGH);
+    else goto bad;
+    return true;
+
+bad:
+    fprintf(stderr, "line %d: %s", number, line);
+    return false;
+}
+
+int compareEdges(const void *a, const void *b) {
+    unsigned long x = ((const Edge *) a)->at, y = ((const Edge *) b)->at;
+    return x < y ? -1 : x > y;
+}
+
+void report(const char *name, uint8_t address) {
+    BusStats &s = hostBus(address);
+
+    printf("%-8s 0x%02x %12lu %10lu %9lu %6lu\n", name, address,
+           s.transactions, s.bytes,
+           s.transactions ? s.bytes / s.transactions : 0, s.nacks);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = NULL, *script = NULL;
+    unsigned long length = 0;
+    unsigned long written = 0;
+    uint16_t updates;
+    uint16_t next = 0;
+    char line[128];
+    int number = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) length = atol(argv[++i]);
+        else script = argv[i];
+    }
+
+    if (script) {
+        FILE *f = fopen(script, "r");
+        if (f == NULL) { perror(script); return 1; }
+        while (fgets(line, sizeof(line), f))
+            if (!parse(line, ++number)) return 1;
+        fclose(f);
+    } else {
+        const char *s = defaultScript;
+        while (*s) {
+            size_t n = strcspn(s, "\n") + 1;
+            memcpy(line, s, n);
+            line[n] = '\0';
+            parse(line, ++number);
+            s += n;
+        }
+    }
+    qsort(edges, nEdges, sizeof(Edge), compareEdges);
+
+    if (length == 0)
+        length = (nEdges ? edges[nEdges - 1].at / 1000 : 0) + 1000;
+
+    setup();
+    updates = display.updates;
+
+    while (millis() < length) {
+        while (next < nEdges && edges[next].at <= micros()) {
+            hostPin(edges[next].pin, edges[next].level);
+            next++;
+        }
+
+        loop();
+        hostAdvance(HOST_LOOP_US);
+
+        if (display.updates != updates) {
+            updates = display.updates;
+            if (dir) {
+                char name[256];
+                snprintf(name, sizeof(name), "%s/frame-%04lu.pbm", dir, written);
+                FILE *f = fopen(name, "wb");
+                if (f == NULL) { perror(name); return 1; }
+                hostPanelPbm(f);
+                fclose(f);
+            }
+            written++;
+        }
+    }
+
+    printf("\n%lu ms, %lu passes, %lu frames, %lu flushes\n",
+           millis(), passes, frames, written);
+    printf("%-8s %4s %12s %10s %9s %6s\n", "device", "addr", "transactions",
+           "bytes", "bytes/tr", "nacks");
+    report("mux", MUX_ADDR);
+    report("oled", OLED_ADDR);
+    report("eeprom", EEPROM_ADDR);
+    report("lcd", 0x27);
+    printf("encoder edges %u, invalid %u, dropped events %u\n",
+           encoder.edges, encoder.invalid, events.dropped);
+
+    return 0;
+}
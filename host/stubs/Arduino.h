@@ -0,0 +1,132 @@
+// Arduino - Angelo Z. (2025)
+
+/*
+  Stand-in for the Arduino core on Linux, for host/ only.
+
+  Time is the virtual clock of host.cpp: it moves with delay(), with
+  the I2C transfers and with the loop passes of the runner, and the
+  interrupts (Timer1, INT0/INT1, PCINT0) fire on it. The registers the
+  sketch reads are plain variables driven by hostPin().
+
+  The host is LP64: long is 8 bytes here and 4 on the AVR. The sketch
+  uses int32_t where the size is stored or sent.
+*/
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+// attachInterrupt() modes, as on the AVR
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define F_CPU 16000000L
+
+// Pins of the Uno
+#define SDA 18
+#define SCL 19
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+#define B00000 0
+#define B00100 4
+#define B01110 14
+#define B11111 31
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+
+/* ===================== Registers ===================== */
+// PINB is pins 8..13, PIND pins 0..7. SREG bit 7 is the I flag.
+extern volatile uint8_t PINB, PIND, PCICR, PCMSK0, SREG;
+
+#define PINB0  0
+#define PIND2  2
+#define PIND3  3
+#define PCINT0 0
+#define PCIE0  0
+
+#define ISR(vector) extern "C" void vector(void)
+
+inline void cli() { SREG &= ~0x80; }
+void sei();
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+/* ===================== Core ===================== */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+void attachInterrupt(uint8_t num, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t num);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+/* ===================== Print ===================== */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const uint8_t *buf, size_t n) {
+        for (size_t i = 0; i < n; i++) write(buf[i]);
+        return n;
+    }
+
+    size_t print(const char *s) {
+        size_t n = 0;
+        while (*s) n += write((uint8_t) *s++);
+        return n;
+    }
+    size_t print(char c)          { return write((uint8_t) c); }
+    size_t print(unsigned char v) { return print((unsigned long) v); }
+    size_t print(int v)           { return print((long) v); }
+    size_t print(unsigned int v)  { return print((unsigned long) v); }
+    size_t print(long v) {
+        if (v >= 0) return print((unsigned long) v);
+        return write('-') + print(-(unsigned long) v);
+    }
+    size_t print(unsigned long v) {
+        char buf[21];
+        snprintf(buf, sizeof(buf), "%lu", v);
+        return print((const char *) buf);
+    }
+
+    size_t println()                  { return print("\r\n"); }
+    template <class T> size_t println(T v) { return print(v) + println(); }
+};
+
+// stdout
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
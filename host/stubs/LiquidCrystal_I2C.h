@@ -0,0 +1,153 @@
+// LiquidCrystal_I2C - Angelo Z. (2025)
+
+/*
+  Stand-in for the LiquidCrystal_I2C library, same protocol: the
+  HD44780 in 4 bit mode behind a PCF8574. Every nibble is three writes
+  of the expander (data, enable high, enable low):
+
+      P7..P4  D7..D4   P3 backlight   P2 E   P1 RW   P0 RS
+
+  so a byte to the LCD is 6 transactions of address + data, 12 bytes
+  on the bus. The HD44780 model in host.cpp decodes them.
+*/
+#ifndef LIQUIDCRYSTAL_I2C_H
+#define LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define LCD_CLEARDISPLAY   0x01
+#define LCD_RETURNHOME     0x02
+#define LCD_ENTRYMODESET   0x04
+#define LCD_DISPLAYCONTROL 0x08
+#define LCD_CURSORSHIFT    0x10
+#define LCD_FUNCTIONSET    0x20
+#define LCD_SETCGRAMADDR   0x40
+#define LCD_SETDDRAMADDR   0x80
+
+#define LCD_ENTRYLEFT           0x02
+#define LCD_ENTRYSHIFTINCREMENT 0x01
+#define LCD_DISPLAYON 0x04
+#define LCD_CURSORON  0x02
+#define LCD_BLINKON   0x01
+#define LCD_4BITMODE  0x00
+#define LCD_2LINE     0x08
+#define LCD_5x8DOTS   0x00
+
+#define LCD_BACKLIGHT   0x08
+#define LCD_NOBACKLIGHT 0x00
+
+#define En 0x04
+#define Rw 0x02
+#define Rs 0x01
+
+
+class LiquidCrystal_I2C : public Print {
+public:
+    LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows) {
+        address = addr;
+        this->cols = cols;
+        this->rows = rows;
+        backlightVal = LCD_NOBACKLIGHT;
+    }
+
+    void init() {
+        Wire.begin();
+        displayFunction = LCD_4BITMODE | LCD_5x8DOTS | (rows > 1 ? LCD_2LINE : 0);
+
+        delay(50);
+        expanderWrite(backlightVal);
+
+        // Three times 8 bit mode, then 4 bit mode
+        write4bits(0x03 << 4);
+        delayMicroseconds(4500);
+        write4bits(0x03 << 4);
+        delayMicroseconds(4500);
+        write4bits(0x03 << 4);
+        delayMicroseconds(150);
+        write4bits(0x02 << 4);
+
+        command(LCD_FUNCTIONSET | displayFunction);
+        displayControl = LCD_DISPLAYON;
+        command(LCD_DISPLAYCONTROL | displayControl);
+        clear();
+        displayMode = LCD_ENTRYLEFT;
+        command(LCD_ENTRYMODESET | displayMode);
+        home();
+    }
+
+    void clear() { command(LCD_CLEARDISPLAY); delayMicroseconds(2000); }
+    void home()  { command(LCD_RETURNHOME); delayMicroseconds(2000); }
+
+    void setCursor(uint8_t col, uint8_t row) {
+        static const uint8_t offsets[] = { 0x00, 0x40, 0x14, 0x54 };
+        if (row >= rows) row = rows - 1;
+        command(LCD_SETDDRAMADDR | (col + offsets[row]));
+    }
+
+    void noCursor()     { control(LCD_CURSORON, false); }
+    void cursor()       { control(LCD_CURSORON, true); }
+    void noBlink()      { control(LCD_BLINKON, false); }
+    void blink()        { control(LCD_BLINKON, true); }
+    void noDisplay()    { control(LCD_DISPLAYON, false); }
+    void display()      { control(LCD_DISPLAYON, true); }
+
+    void autoscroll()   { mode(LCD_ENTRYSHIFTINCREMENT, true); }
+    void noAutoscroll() { mode(LCD_ENTRYSHIFTINCREMENT, false); }
+
+    void noBacklight()  { backlightVal = LCD_NOBACKLIGHT; expanderWrite(0); }
+    void backlight()    { backlightVal = LCD_BACKLIGHT; expanderWrite(0); }
+
+    void createChar(uint8_t location, uint8_t charmap[]) {
+        command(LCD_SETCGRAMADDR | (location & 7) << 3);
+        for (uint8_t i = 0; i < 8; i++) write(charmap[i]);
+    }
+
+    size_t write(uint8_t value) {
+        send(value, Rs);
+        return 1;
+    }
+    using Print::write;
+
+    void command(uint8_t value) { send(value, 0); }
+
+protected:
+    uint8_t address, cols, rows;
+    uint8_t displayFunction, displayControl, displayMode;
+    uint8_t backlightVal;
+
+    void control(uint8_t bit, bool on) {
+        if (on) displayControl |= bit; else displayControl &= ~bit;
+        command(LCD_DISPLAYCONTROL | displayControl);
+    }
+
+    void mode(uint8_t bit, bool on) {
+        if (on) displayMode |= bit; else displayMode &= ~bit;
+        command(LCD_ENTRYMODESET | displayMode);
+    }
+
+    void send(uint8_t value, uint8_t rs) {
+        write4bits((value & 0xf0) | rs);
+        write4bits((value << 4 & 0xf0) | rs);
+    }
+
+    void write4bits(uint8_t value) {
+        expanderWrite(value);
+        pulseEnable(value);
+    }
+
+    void expanderWrite(uint8_t data) {
+        Wire.beginTransmission(address);
+        Wire.write(data | backlightVal);
+        Wire.endTransmission();
+    }
+
+    void pulseEnable(uint8_t data) {
+        expanderWrite(data | En);
+        delayMicroseconds(1);
+        expanderWrite(data & ~En);
+        delayMicroseconds(50);
+    }
+};
+
+#endif
@@ -0,0 +1,163 @@
+// OLED_I2C - Angelo Z. (2025)
+
+/*
+  Stand-in for the OLED_I2C library, the part the sketch uses. It draws
+  in scrbuf like the library (page layout, LSB at the top) and talks to
+  the SSD1306 model at 0x3C through Wire: the library has its own TWI
+  code on the hardware pins, the bytes on the bus are the same.
+*/
+#ifndef OLED_I2C_H
+#define OLED_I2C_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "host.h"
+
+#define LEFT   0
+#define RIGHT  9999
+#define CENTER 9998
+
+#define SSD1306_128X64 1
+#define SSD1306_ADDR   0x3C
+
+struct _current_font {
+    uint8_t *font;
+    uint8_t x_size;
+    uint8_t y_size;
+    uint8_t offset;
+    uint8_t numchars;
+    uint8_t inverted;
+};
+
+
+class OLED {
+public:
+    OLED(uint8_t data_pin, uint8_t sclk_pin) {
+        cfont.font = NULL;
+        cfont.inverted = 0;
+        memset(scrbuf, 0, sizeof(scrbuf));
+        hostScreenBuffer(scrbuf);
+    }
+
+    // Same sequence as the library, horizontal addressing included
+    void begin(uint8_t type = SSD1306_128X64) {
+        static const uint8_t init[] = {
+            0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14,
+            0x20, 0x00, 0xA1, 0xC8, 0xDA, 0x12, 0x81, 0xCF, 0xD9, 0xF1,
+            0xDB, 0x40, 0xA4, 0xA6, 0xAF
+        };
+
+        for (uint8_t i = 0; i < sizeof(init); i++) sendCommand(init[i]);
+        clrScr();
+        update();
+    }
+
+    // The whole buffer
+    void update() {
+        static const uint8_t window[] = { 0x21, 0, 127, 0x22, 0, 7 };
+
+        for (uint8_t i = 0; i < sizeof(window); i++) sendCommand(window[i]);
+        for (int i = 0; i < 1024; i += 16) {
+            Wire.beginTransmission(SSD1306_ADDR);
+            Wire.write(0x40);
+            Wire.write(scrbuf + i, 16);
+            Wire.endTransmission();
+        }
+    }
+
+    void setBrightness(uint8_t value) {
+        sendCommand(0x81);
+        sendCommand(value);
+    }
+
+    void invert(bool mode) {
+        sendCommand(mode ? 0xA7 : 0xA6);
+    }
+
+    /* ===================== Drawing ===================== */
+    void clrScr()  { memset(scrbuf, 0, sizeof(scrbuf)); }
+    void fillScr() { memset(scrbuf, 0xff, sizeof(scrbuf)); }
+
+    void setPixel(uint16_t x, uint16_t y) {
+        if (x < 128 && y < 64) scrbuf[(y / 8) * 128 + x] |= 1 << (y % 8);
+    }
+
+    void clrPixel(uint16_t x, uint16_t y) {
+        if (x < 128 && y < 64) scrbuf[(y / 8) * 128 + x] &= ~(1 << (y % 8));
+    }
+
+    void invertText(bool mode) { cfont.inverted = mode; }
+
+    void print(char *st, int x, int y) {
+        int len = strlen(st);
+
+        if (x == RIGHT) x = 128 - len * cfont.x_size;
+        if (x == CENTER) x = (128 - len * cfont.x_size) / 2;
+
+        for (int i = 0; i < len; i++) printChar(st[i], x + i * cfont.x_size, y);
+    }
+
+    void drawLine(int x1, int y1, int x2, int y2) {
+        int dx = abs(x2 - x1), dy = -abs(y2 - y1);
+        int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+        int err = dx + dy;
+
+        for (;;) {
+            setPixel(x1, y1);
+            if (x1 == x2 && y1 == y2) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x1 += sx; }
+            if (e2 <= dx) { err += dx; y1 += sy; }
+        }
+    }
+
+    void drawRect(int x1, int y1, int x2, int y2) {
+        drawLine(x1, y1, x2, y1);
+        drawLine(x1, y2, x2, y2);
+        drawLine(x1, y1, x1, y2);
+        drawLine(x2, y1, x2, y2);
+    }
+
+    void setFont(uint8_t *font) {
+        cfont.font = font;
+        cfont.x_size = font[0];
+        cfont.y_size = font[1];
+        cfont.offset = font[2];
+        cfont.numchars = font[3];
+    }
+
+protected:
+    _current_font cfont;
+    uint8_t scrbuf[1024];
+
+    void sendCommand(uint8_t c) {
+        Wire.beginTransmission(SSD1306_ADDR);
+        Wire.write(0x80);   // One command
+        Wire.write(c);
+        Wire.endTransmission();
+    }
+
+    // Pixel by pixel, at any y. Glyphs of fonts taller than 8 are
+    // stored a page after the other.
+    void printChar(unsigned char c, int x, int y) {
+        if (cfont.font == NULL || c < cfont.offset
+                               || c >= cfont.offset + cfont.numchars)
+            return;
+
+        const uint8_t *glyph = cfont.font + 4
+                             + (c - cfont.offset) * cfont.x_size * (cfont.y_size / 8);
+
+        for (int i = 0; i < cfont.x_size; i++) {
+            for (int j = 0; j < cfont.y_size; j++) {
+                boolean on = glyph[(j / 8) * cfont.x_size + i] & (1 << (j % 8));
+
+                if (cfont.inverted) on = !on;
+                if (x + i < 0 || y + j < 0) continue;
+                if (on) setPixel(x + i, y + j);
+                else clrPixel(x + i, y + j);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,56 @@
+// TimerOne - Angelo Z. (2025)
+
+/*
+  Stand-in for the TimerOne library: the callback fires on the virtual
+  clock, every period while the timer runs.
+*/
+#ifndef TIMERONE_H
+#define TIMERONE_H
+
+#include <Arduino.h>
+
+
+class TimerOne {
+public:
+    void (*isr)(void);
+    unsigned long period;   // us
+    unsigned long next;     // micros() of the next tick
+    boolean running;
+
+    TimerOne() {
+        isr = NULL;
+        period = 1000000;
+        next = 0;
+        running = false;
+    }
+
+    // Like the library, the timer counts from here
+    void initialize(long microseconds = 1000000) {
+        setPeriod(microseconds);
+        running = true;
+    }
+
+    void setPeriod(long microseconds) {
+        period = microseconds;
+        next = micros() + period;
+    }
+
+    void attachInterrupt(void (*fn)(void), long microseconds = -1) {
+        if (microseconds > 0) setPeriod(microseconds);
+        isr = fn;
+    }
+
+    void detachInterrupt() { isr = NULL; }
+
+    void start()   { next = micros() + period; running = true; }
+    void restart() { start(); }
+    void resume() {
+        if ((long) (next - micros()) < 0) next = micros() + period;
+        running = true;
+    }
+    void stop()    { running = false; }
+};
+
+extern TimerOne Timer1;
+
+#endif
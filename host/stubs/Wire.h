@@ -0,0 +1,47 @@
+// Wire - Angelo Z. (2025)
+
+/*
+  Stand-in for the Wire library. The transactions go to the devices
+  modelled in host.cpp, behind the mux, and take their time on the
+  virtual clock at the speed set with setClock().
+
+  Same limits as the AVR library: 32 bytes of buffer, the bytes over
+  it are dropped.
+*/
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+
+class TwoWire {
+public:
+    TwoWire();
+
+    void begin() {}
+    void setClock(uint32_t hz) { clock = hz; }
+
+    void beginTransmission(uint8_t address);
+    // 0 ok, 1 too long, 2 address not acknowledged
+    uint8_t endTransmission(bool stop = true);
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t n);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+    int available() { return rxLen - rxPos; }
+    int read() { return rxPos < rxLen ? rxBuf[rxPos++] : -1; }
+
+protected:
+    uint32_t clock;
+    uint8_t address;
+    uint8_t txBuf[BUFFER_LENGTH], txLen;
+    boolean overflow;
+    uint8_t rxBuf[BUFFER_LENGTH], rxLen, rxPos;
+};
+
+extern TwoWire Wire;
+
+#endif
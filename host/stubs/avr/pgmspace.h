@@ -0,0 +1,25 @@
+// pgmspace - Angelo Z. (2025)
+
+/*
+  Flash is RAM on the host. The reads keep the type of the pointer:
+  pgm_read_dword() of a long is a long, also on a 64 bit host.
+*/
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr)  (*(addr))
+#define pgm_read_word(addr)  (*(addr))
+#define pgm_read_dword(addr) (*(addr))
+#define pgm_read_ptr(addr)   (*(addr))
+
+#define memcpy_P  memcpy
+#define strlen_P  strlen
+#define strncpy_P strncpy
+#define strcpy_P  strcpy
+
+#endif
@@ -0,0 +1,12 @@
+// Eeprom - Angelo Z. (2025)
+
+/*
+  Stand-in for eeprom.h, which is not in the tree. The journal in
+  menu.cpp talks to the 24LC32 straight through Wire.
+*/
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <Wire.h>
+
+#endif
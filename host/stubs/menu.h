@@ -0,0 +1,34 @@
+// Menu - Angelo Z. (2025)
+
+/*
+  Stand-in for menu.h, which is not in the tree: the prototypes of the
+  sketch used before their definition.
+*/
+#ifndef MENU_DECLS_H
+#define MENU_DECLS_H
+
+#include <Arduino.h>
+
+void storeData();
+void exitMain();
+void _lcd();
+void leaveMenu();
+void option();
+void lampOfGod();
+void closeItem();
+void chipSelect(byte bus);
+void drawRect();
+void countUp();
+void countDown();
+void updateButton();
+boolean buttonClicked();
+boolean buttonReleased();
+boolean buttonHold();
+boolean buttonPressed();
+void drawMenus();
+void drawItems();
+void openMenu();
+void window();
+void menuTone();
+
+#endif
@@ -0,0 +1,44 @@
+// Check - Angelo Z. (2025)
+
+/*
+  The smallest test harness. A test is a function, CHECK() counts what
+  fails and goes on, done() prints the count and is the exit status.
+
+      CHECK(values[VAL_CLOCK_0] == 9000);
+      CHECK_EQ(hostBus(OLED_ADDR).nacks, 0);   prints both sides
+*/
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static unsigned checks = 0, failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(a, b) checkEq((long long) (a), (long long) (b), #a, #b, __FILE__, __LINE__)
+
+static inline bool check(bool ok, const char *what, const char *file, int line) {
+    checks++;
+    if (!ok) {
+        failures++;
+        printf("%s:%d: failed: %s\n", file, line, what);
+    }
+    return ok;
+}
+
+static inline bool checkEq(long long a, long long b, const char *x, const char *y,
+                           const char *file, int line) {
+    checks++;
+    if (a != b) {
+        failures++;
+        printf("%s:%d: failed: %s == %s (%lld, %lld)\n", file, line, x, y, a, b);
+    }
+    return a == b;
+}
+
+static inline int done(const char *name) {
+    printf("%s: %u checks, %u failed\n", name, checks, failures);
+    return failures != 0;
+}
+
+#endif
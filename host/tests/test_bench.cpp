@@ -0,0 +1,51 @@
+// Benchmark test - Angelo Z. (2025)
+
+/*
+  The startup benchmarks leave the sketch as they found it: the real
+  journal is not written, values and flags are the same. Every one of
+  them draws something, on the OLED or on the LCD.
+*/
+#include "check.h"
+#include "host.h"
+
+#define BENCHMARK 1
+#include "../../menu.cpp"
+
+void testSave() {
+    FILE *out = stdout;
+    long before[N_VALUES];
+    uint8_t flags[N_ITEMS];
+    uint8_t *cells = hostEeprom();
+
+    // setup() runs the benchmarks, quietly
+    stdout = fopen("/dev/null", "w");
+    initItems();
+    memcpy(before, values, sizeof(before));
+    memcpy(flags, itemFlags, sizeof(flags));
+    setup();
+    fclose(stdout);
+    stdout = out;
+
+    // The scratch journal has been written, the real one not
+    uint16_t scratch = 0, real = 0;
+    for (int a = 0; a < JOURNAL_SLOTS * RECORD_SIZE; a++) {
+        if (cells[BENCH_JOURNAL + a] != 0xff) scratch++;
+        if (cells[JOURNAL_START + a] != 0xff) real++;
+    }
+    CHECK(scratch > 0);
+    CHECK_EQ(real, 0);
+
+    CHECK_EQ(journalStart, JOURNAL_START);
+    CHECK_EQ(journalHead, 0);
+    CHECK(memcmp(values, before, sizeof(before)) == 0);
+    for (uint8_t i = 0; i < N_ITEMS; i++) CHECK_EQ(itemFlags[i], flags[i]);
+
+    // Updates and bytes on the bus for each one
+    CHECK_EQ(benchesRun, 7);
+    CHECK_EQ(benchesSilent, 0);
+}
+
+int main() {
+    testSave();
+    return done("bench");
+}
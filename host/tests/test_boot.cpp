@@ -0,0 +1,50 @@
+// Boot test - Angelo Z. (2025)
+
+/*
+  The sketch boots on the virtual board and the panel shows what is in
+  the buffer, with input through the pins.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+void testBoot() {
+    setup();
+    hostRun(100);
+
+    CHECK_EQ(depth, 0);
+    CHECK(treeInOrder());
+    CHECK(hostPanelIsBuffer());
+    CHECK(!hostPanelInverted());
+    CHECK_EQ(hostBus(OLED_ADDR).nacks, 0);
+    CHECK_EQ(hostBus(0x27).nacks, 0);
+    CHECK_EQ(hostBus(OLED_ADDR).overflows, 0);
+}
+
+void testClick() {
+    // SETTINGS
+    hostClick();
+
+    CHECK_EQ(depth, 1);
+    CHECK_EQ(indexMenu, SETTINGS_MENU);
+    CHECK(hostPanelIsBuffer());
+}
+
+void testTurn() {
+    // MAIN: SETTINGS -> DISPLAY
+    leaveMenu();
+    hostRun(100);
+    hostTurn(1, 40000, 1);
+    hostRun(100);
+
+    CHECK_EQ(cursor, 1);
+    CHECK_EQ(encoder.invalid, 0);
+    CHECK(hostPanelIsBuffer());
+}
+
+int main() {
+    testBoot();
+    testClick();
+    testTurn();
+    return done("boot");
+}
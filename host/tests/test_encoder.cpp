@@ -0,0 +1,121 @@
+// Encoder test - Angelo Z. (2025)
+
+/*
+  The decoder on quadrature traces through pins 2 and 3, from a slow
+  turn to 100 us a detent, clean and bouncing: every detent arrives,
+  with the time of its last edge. An edge lost is an invalid step, not
+  a detent, and what doesn't fit even in pending is counted.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// AB one step after the other in the +1 direction
+const uint8_t gray[4] = { 0, 1, 3, 2 };
+
+// What updateButton() does with the detents
+long drain() {
+    InputEvent ev = { 0, 0, 0 };
+    long sum = 0;
+
+    while (events.pop(ev))
+        if (ev.type == EV_DETENT) sum += ev.value;
+    return sum + encoder.take();
+}
+
+// detents in chunks, the main loop taking them in between
+long traced(int16_t detents, unsigned long usPerDetent, uint8_t bounces) {
+    int8_t dir = detents < 0 ? -1 : 1;
+    long sum = 0;
+
+    for (int16_t n = abs(detents); n > 0; n -= 10) {
+        hostTurn(dir * min(n, 10), usPerDetent, bounces);
+        sum += drain();
+    }
+    return sum;
+}
+
+void testTraces() {
+    const unsigned long speeds[] = { 40000, 4000, 1000, 250, 100 };
+
+    setup();
+    hostRun(100);
+    drain();
+
+    for (uint8_t s = 0; s < LIST(speeds); s++) {
+        for (uint8_t b = 0; b <= 2; b += 2) {
+            CHECK_EQ(traced(200, speeds[s], b), 200);
+            CHECK_EQ(traced(-200, speeds[s], b), -200);
+        }
+    }
+    CHECK_EQ(encoder.invalid, 0);
+    CHECK_EQ(events.dropped, 0);
+
+    // Back and forth, taken at the end
+    hostTurn(50, 1000, 1);
+    hostTurn(-30, 1000, 1);
+    hostTurn(7, 1000, 1);
+    CHECK_EQ(drain(), 27);
+}
+
+// A detent carries the time of its last edge, as many as the queue holds
+void testTimes() {
+    InputEvent ev = { 0, 0, 0 };
+    unsigned long last = 0;
+    uint8_t n = 0;
+
+    hostTurn(EVENT_QUEUE_SIZE - 1, 3000);
+    while (events.pop(ev)) {
+        if (n++) CHECK_EQ(ev.time - last, 3000);
+        last = ev.time;
+    }
+    CHECK_EQ(n, EVENT_QUEUE_SIZE - 1);
+}
+
+// Nothing moves, nothing runs
+void testIdle() {
+    uint16_t edges = encoder.edges;
+
+    hostRun(1000);
+    CHECK_EQ(encoder.edges, edges);
+}
+
+// A and B change together: the direction is unknown
+void testLostEdge() {
+    QuadratureDecoder q(StepsPerNotch);
+    EventQueue queue;
+
+    q.begin(0);
+    q.update(3, 0, queue);
+    CHECK_EQ(q.invalid, 1);
+    q.update(2, 0, queue);
+    q.update(0, 0, queue);
+    q.update(3, 0, queue);
+    CHECK_EQ(q.invalid, 2);
+    CHECK(queue.empty());
+    CHECK_EQ(q.take(), 0);
+}
+
+// Past what pending holds, the detents are counted as dropped
+void testSaturation() {
+    QuadratureDecoder q(StepsPerNotch);
+    EventQueue queue;
+    long detents = (EVENT_QUEUE_SIZE - 1) + 32766L + 5;
+    uint8_t s = 0;
+
+    q.begin(0);
+    for (long n = 0; n < 4 * detents; n++)
+        q.update(gray[++s & 3], n, queue);
+
+    CHECK_EQ(q.take(), 32766);
+    CHECK_EQ(queue.dropped, 5);
+}
+
+int main() {
+    testTraces();
+    testTimes();
+    testIdle();
+    testLostEdge();
+    testSaturation();
+    return done("encoder");
+}
@@ -0,0 +1,82 @@
+// Event queue test - Angelo Z. (2025)
+
+/*
+  Bursts of input while the main loop is busy: what fits in the queue
+  arrives in order, what doesn't is counted, and detents are never
+  dropped.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+void testQueue() {
+    EventQueue q;
+    InputEvent ev = { 0, 0, 0 };
+
+    for (uint8_t i = 0; i < EVENT_QUEUE_SIZE - 1; i++)
+        CHECK(q.push(EV_DETENT, i, 1000UL * i));
+    CHECK(q.full());
+    CHECK(!q.push(EV_CLICK, 0, 0));
+    CHECK_EQ(q.dropped, 1);
+
+    for (uint8_t i = 0; i < EVENT_QUEUE_SIZE - 1; i++) {
+        CHECK(q.pop(ev));
+        CHECK_EQ(ev.value, i);
+        CHECK_EQ(ev.time, 1000UL * i);
+    }
+    CHECK(!q.pop(ev));
+    CHECK(q.empty());
+}
+
+// Clicks on the pin, with bounces. The main loop doesn't run.
+void clicks(uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+        hostButton(true, 3);
+        hostAdvance(40000);
+        hostButton(false, 3);
+        hostAdvance(40000);
+    }
+    hostAdvance(300000);
+}
+
+void testBurst() {
+    setup();
+    hostRun(100);
+
+    // Two clicks, six events: they fit
+    clicks(2);
+    CHECK_EQ(events.dropped, 0);
+
+    updateButton();
+    CHECK_EQ(button.clicks, 2);
+    CHECK_EQ(button.doubles, 1);
+    button.clicks = button.doubles = 0;
+}
+
+void testOverflow() {
+    // Six clicks, 18 events in EVENT_QUEUE_SIZE - 1 places
+    clicks(6);
+    CHECK_EQ(events.dropped, 18 - (EVENT_QUEUE_SIZE - 1));
+    updateButton();
+    button.clicks = button.doubles = 0;
+    events.dropped = 0;
+}
+
+void testDetents() {
+    // 40 detents with the queue full of clicks: all of them arrive
+    clicks(5);
+    hostTurn(40, 2000);
+    rotaryDelta();
+    updateButton();
+
+    CHECK_EQ(rotaryDelta(), 40);
+    CHECK_EQ(encoder.invalid, 0);
+}
+
+int main() {
+    testQueue();
+    testBurst();
+    testOverflow();
+    testDetents();
+    return done("events");
+}
@@ -0,0 +1,143 @@
+// Journal test - Angelo Z. (2025)
+
+/*
+  The eeprom journal across power cuts. The power goes after any byte
+  of a save, the board boots again and every saved item must have its
+  old or its new value, never a mix; the next save must win over
+  whatever the cut left behind, also when the journal changes bank.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// Items and their values
+const uint8_t saved[] = { CLOCK_0, MENU_LOOP, KEY_TONE };
+const uint8_t savedValue[] = { VAL_CLOCK_0, VAL_MENU_LOOP, VAL_KEY_TONE };
+#define N_SAVED sizeof(saved)
+
+// What boot does, on a board that lost its power
+void reboot() {
+    hostPowerOn();
+    i2c = I2CBus();
+    scheduler.stop(commitData);
+    saveAgain = snapshot = false;
+    journalHead = 0;
+    journalSeq = 0;
+    initItems();
+    loadData();
+}
+
+// A save to the end, or until the power goes
+void save() {
+    storeData();
+    while (scheduler.pending(commitData) && !hostPowerLost())
+        hostRun(1);
+}
+
+void set(const long *v) {
+    for (uint8_t i = 0; i < N_SAVED; i++) {
+        values[savedValue[i]] = v[i];
+        itemFlags[saved[i]] |= Modified;
+    }
+}
+
+boolean loaded(const long *v) {
+    for (uint8_t i = 0; i < N_SAVED; i++)
+        if (values[savedValue[i]] != v[i]) return false;
+    return true;
+}
+
+void testErased() {
+    setup();
+    hostRun(100);
+
+    CHECK_EQ(journalHead, 0);
+    CHECK_EQ(values[VAL_CLOCK_0], 8000);
+    CHECK_EQ(values[VAL_MENU_LOOP], 0);
+}
+
+// Every byte of one save
+void testEveryByte() {
+    const long before[N_SAVED] = { 12000, 1, 0 };
+    const long after[N_SAVED] = { 150000, 0, 1 };
+    static uint8_t image[EEPROM_SIZE];
+    long bytes = 0;
+
+    set(before);
+    save();
+    reboot();
+    CHECK(loaded(before));
+    memcpy(image, hostEeprom(), EEPROM_SIZE);
+
+    // The size of the save
+    set(after);
+    save();
+    bytes = saveBytes;
+    CHECK(bytes > 0);
+    printf("save: %ld bytes\n", bytes);
+
+    for (long cut = 0; cut <= bytes; cut++) {
+        memcpy(hostEeprom(), image, EEPROM_SIZE);
+        reboot();
+        set(after);
+        hostPowerCut(cut);
+        save();
+        reboot();
+
+        for (uint8_t i = 0; i < N_SAVED; i++) {
+            long v = values[savedValue[i]];
+            CHECK(v == before[i] || v == after[i]);
+        }
+        // The save after the cut wins
+        set(after);
+        save();
+        reboot();
+        CHECK(loaded(after));
+    }
+}
+
+// Many saves through both banks, some of them cut short
+void testBanks() {
+    long old[N_SAVED], want[N_SAVED];
+    uint16_t cuts = 0, laps = 0;
+    uint8_t head = journalHead;
+
+    srand(7);
+    for (uint8_t i = 0; i < N_SAVED; i++) old[i] = values[savedValue[i]];
+
+    for (int n = 0; n < 400; n++) {
+        want[0] = 8000 + rand() % 1000000;
+        want[1] = rand() & 1;
+        want[2] = rand() & 1;
+        set(want);
+
+        boolean cut = rand() % 3 == 0;
+        if (cut) {
+            hostPowerCut(rand() % (JOURNAL_SLOTS * RECORD_SIZE / 4));
+            cuts++;
+        }
+        save();
+        if (cut && !hostPowerLost()) hostPowerCut(-1);
+        reboot();
+
+        if (journalHead < head) laps++;
+        head = journalHead;
+
+        for (uint8_t i = 0; i < N_SAVED; i++) {
+            long v = values[savedValue[i]];
+            if (!CHECK(v == old[i] || v == want[i])) return;
+            if (!cut) CHECK_EQ(v, want[i]);
+            old[i] = v;
+        }
+    }
+
+    CHECK(cuts > 0);
+    CHECK(laps >= 2);
+}
+
+int main() {
+    testErased();
+    testEveryByte();
+    testBanks();
+    return done("journal");
+}
@@ -0,0 +1,107 @@
+// Digit editor test - Angelo Z. (2025)
+
+/*
+  CLOCK 0 on the LCD, through the pins. The HD44780 behind the
+  expander shows what the editor means to show, and the bus carries
+  only what changed: nothing while idle, a setCursor() for a move, a
+  character and a setCursor() for a digit. The bytes counted by
+  LcdTarget are the bytes on the bus.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+#define LCD_ADDR 0x27
+
+// HD44780 display control
+#define LCD_CURSOR_BIT 2
+#define LCD_BLINK_BIT  1
+
+unsigned long lcdBytes() {
+    return hostBus(LCD_ADDR).bytes;
+}
+
+// Bytes of a step on the bus, checked against the count of LcdTarget
+unsigned long step(int16_t detents, boolean press) {
+    unsigned long bus = lcdBytes(), own = lcdTarget.bytes;
+
+    if (detents) {
+        hostTurn(detents, 1000);
+        hostRun(100);
+    }
+    if (press) hostClick();
+
+    CHECK_EQ(lcdBytes() - bus, lcdTarget.bytes - own);
+    CHECK_EQ(hostBus(LCD_ADDR).nacks, 0);
+    return lcdBytes() - bus;
+}
+
+void testOpen() {
+    setup();
+    hostRun(100);
+    unlockItem(menuItem(SETTINGS_MENU, 0));
+
+    // SETTINGS > CLOCK 0
+    hostClick();
+    hostClick();
+    CHECK(editor.active());
+
+    CHECK(!strcmp(hostLcdLine(0), "000 008 000     "));
+    CHECK_EQ(hostLcdLine(1)[0], '*');
+    CHECK_EQ(hostLcdLine(1)[15], '>');
+    CHECK_EQ(hostLcdAddress(), 0);
+    CHECK(hostLcdControl() & LCD_BLINK_BIT);
+
+    // Idle: nothing on the bus
+    unsigned long bus = lcdBytes();
+    hostRun(1000);
+    CHECK_EQ(lcdBytes() - bus, 0);
+}
+
+void testEdit() {
+    // Next digit: the address only
+    CHECK_EQ(step(1, false), LCD_BUS_BYTES);
+    CHECK_EQ(hostLcdAddress(), 1);
+
+    // Digit mode: cursor and blink
+    CHECK_EQ(step(0, true), 2 * LCD_BUS_BYTES);
+    CHECK(hostLcdControl() & LCD_CURSOR_BIT);
+    CHECK(!(hostLcdControl() & LCD_BLINK_BIT));
+
+    // A digit: the character and the address back on it
+    CHECK_EQ(step(1, false), 2 * LCD_BUS_BYTES);
+    CHECK(!strcmp(hostLcdLine(0), "010 008 000     "));
+    CHECK_EQ(hostLcdAddress(), 1);
+
+    // Three detents in a frame, one write
+    CHECK_EQ(step(3, false), 2 * LCD_BUS_BYTES);
+    CHECK(!strcmp(hostLcdLine(0), "040 008 000     "));
+
+    // Back to select, then eight cells in one frame to the bell
+    CHECK_EQ(step(0, true), 2 * LCD_BUS_BYTES);
+    CHECK_EQ(step(8, false), LCD_BUS_BYTES);
+    CHECK_EQ(hostLcdAddress(), 0x40);
+
+    // Confirm: the digits are already there
+    CHECK_EQ(step(0, true), 2 * LCD_BUS_BYTES);
+    CHECK_EQ(values[VAL_CLOCK_0], 40008000);
+    CHECK(!(hostLcdControl() & (LCD_CURSOR_BIT | LCD_BLINK_BIT)));
+    CHECK_EQ(step(0, false), 0);
+}
+
+// A shorter number clears the digits in front
+void testShorter() {
+    chipSelect(__LCD__I2C);
+    editor.show(123456789);
+    CHECK(!strcmp(hostLcdLine(0), "123 456 789     "));
+    editor.show(8000);
+    CHECK(!strcmp(hostLcdLine(0), "000 008 000     "));
+    editor.show(values[VAL_CLOCK_0]);
+}
+
+int main() {
+    testOpen();
+    testEdit();
+    testShorter();
+    return done("lcd");
+}
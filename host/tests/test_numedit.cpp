@@ -0,0 +1,151 @@
+// Digit editor on the OLED test - Angelo Z. (2025)
+
+/*
+  NumberEditor<5, true, 2, OledTarget> on pages 2 and 3 of the panel,
+  read back cell by cell against the glyphs of SmallFont: the layout,
+  the sign and the digits turned, the value confirmed, negative and
+  fractional values, all nines for what doesn't fit. The cursor is a
+  XOR over a cell, stop() takes it away.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+#define EDIT_PAGE 2
+
+OledTarget oledTarget(display, EDIT_PAGE * 8);
+NumberEditor<5, true, 2, OledTarget> oledEditor(oledTarget);
+
+void flush() {
+    chipSelect(__SCREEN__I2C);
+    display.update();
+    CHECK(hostPanelIsBuffer());
+}
+
+// What the panel has over the glyph of c in a cell: 0 plain, 0xff the
+// block of CURSOR_BLINK, 0x80 the line of CURSOR_LINE, 1 not c at all
+uint8_t cell(uint8_t col, uint8_t row, char c) {
+    const uint8_t *glyph = SmallFont + FONT_HEADER + (c - ' ') * FONT_W;
+    const uint8_t *page = hostPanel() + (EDIT_PAGE + row) * OLED_COLS;
+    uint8_t x = page[col * FONT_W] ^ glyph[0];
+
+    for (uint8_t i = 1; i < FONT_W; i++)
+        if ((page[col * FONT_W + i] ^ glyph[i]) != x) return 1;
+    return x == 0 || x == 0xff || x == 0x80 ? x : 1;
+}
+
+// The number line, no cursor on it
+boolean shows(const char *s) {
+    for (uint8_t i = 0; s[i]; i++)
+        if (cell(i, 0, s[i]) != 0) return false;
+    return true;
+}
+
+void testLayout() {
+    setup();
+    hostRun(100);
+
+    oledEditor.start(12345);
+    flush();
+
+    // The cursor blinks on the sign
+    CHECK_EQ(cell(0, 0, '+'), 0xff);
+    for (uint8_t i = 1; i < 7; i++) CHECK_EQ(cell(i, 0, "+123.45"[i]), 0);
+    CHECK_EQ(cell(0, 1, '^'), 0);
+    CHECK_EQ(cell(OLED_COLS / FONT_W - 1, 1, '>'), 0);
+    CHECK_EQ(oledEditor.value(), 12345);
+}
+
+void testTurn() {
+    // The sign: a line under it while it turns
+    CHECK_EQ(oledEditor.click(), EDIT_NONE);
+    flush();
+    CHECK_EQ(cell(0, 0, '+'), 0x80);
+    oledEditor.turn(1);
+    flush();
+    CHECK_EQ(cell(0, 0, '-'), 0x80);
+    oledEditor.click();
+
+    // The last decimal, five cells on: 5 + 3
+    oledEditor.turn(5);
+    flush();
+    CHECK_EQ(cell(0, 0, '-'), 0);
+    CHECK_EQ(cell(6, 0, '5'), 0xff);
+    oledEditor.click();
+    oledEditor.turn(3);
+    oledEditor.click();
+    flush();
+    CHECK_EQ(cell(6, 0, '8'), 0xff);
+
+    // To the confirm cell, click: the cursor goes
+    oledEditor.turn(1);
+    flush();
+    CHECK_EQ(cell(6, 0, '8'), 0);
+    CHECK_EQ(cell(0, 1, '^'), 0xff);
+    CHECK_EQ(oledEditor.click(), EDIT_CONFIRMED);
+    flush();
+    CHECK_EQ(cell(0, 1, '^'), 0);
+    CHECK(shows("-123.48"));
+    CHECK_EQ(oledEditor.value(), -12348);
+}
+
+// Hundredths: the value is in the smallest unit
+void testValues() {
+    oledEditor.show(7);
+    flush();
+    CHECK(shows("+000.07"));
+    CHECK_EQ(oledEditor.value(), 7);
+
+    oledEditor.show(-5);
+    flush();
+    CHECK(shows("-000.05"));
+    CHECK_EQ(oledEditor.value(), -5);
+
+    oledEditor.show(-99999);
+    flush();
+    CHECK(shows("-999.99"));
+    CHECK_EQ(oledEditor.value(), -99999);
+
+    // Too many digits: all nines, the sign kept
+    oledEditor.show(123456);
+    flush();
+    CHECK(shows("+999.99"));
+    CHECK_EQ(oledEditor.value(), 99999);
+
+    oledEditor.show(-2000000000L);
+    flush();
+    CHECK(shows("-999.99"));
+    CHECK_EQ(oledEditor.value(), -99999);
+}
+
+// Back to select, the cursor blinks again; stop() takes it away
+void testStop() {
+    oledEditor.click();
+    flush();
+    CHECK_EQ(cell(0, 1, '^'), 0xff);
+
+    oledEditor.stop();
+    flush();
+    CHECK(!oledEditor.active());
+    CHECK(shows("-999.99"));
+    CHECK_EQ(cell(0, 1, '^'), 0);
+    CHECK_EQ(cell(OLED_COLS / FONT_W - 1, 1, '>'), 0);
+
+    // In a digit too
+    oledEditor.start(0);
+    oledEditor.turn(2);
+    oledEditor.click();
+    flush();
+    CHECK_EQ(cell(2, 0, '0'), 0x80);
+    oledEditor.stop();
+    flush();
+    CHECK(shows("+000.00"));
+}
+
+int main() {
+    testLayout();
+    testTurn();
+    testValues();
+    testStop();
+    return done("numedit");
+}
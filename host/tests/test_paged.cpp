@@ -0,0 +1,128 @@
+// Paged flush test - Angelo Z. (2025)
+
+/*
+  PagedOLED sends only the dirty columns, and what it sends is enough:
+  after every flush the panel memory is the buffer. The bytes are the
+  ones on the bus, address byte included.
+*/
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// Bytes of one flush, checked against the count of PagedOLED
+unsigned long flush() {
+    unsigned long bus = hostPanelBytes(), own = display.bytesSent;
+
+    chipSelect(__SCREEN__I2C);
+    display.update();
+    CHECK_EQ(hostPanelBytes() - bus, display.bytesSent - own);
+    CHECK(hostPanelIsBuffer());
+    return hostPanelBytes() - bus;
+}
+
+void testSpans() {
+    setup();
+    hostRun(200);
+
+    // Clean: nothing
+    CHECK_EQ(flush(), 0);
+
+    // One pixel: the window and one data byte
+    display.setPixel(3, 3);
+    CHECK_EQ(flush(), 8 + 3);
+
+    // Both ends of a page: two windows, not the whole row
+    display.setPixel(0, 9);
+    display.setPixel(127, 9);
+    CHECK_EQ(flush(), 2 * (8 + 3));
+
+    // Close together: one window
+    display.setPixel(20, 17);
+    display.setPixel(25, 17);
+    CHECK_EQ(flush(), 8 + 2 + 6);
+
+    // A third range joins the second one
+    display.setPixel(0, 30);
+    display.setPixel(60, 30);
+    display.setPixel(127, 30);
+    CHECK(flush() < 8 + 2 + 128);
+
+    display.clrScr();
+    flush();
+}
+
+// Random drawing, the panel must follow
+void testRandom() {
+    srand(1);
+
+    for (int n = 0; n < 300; n++) {
+        int x = rand() % 150 - 10, y = rand() % 80 - 10;
+
+        switch (rand() % 5) {
+            case 0: display.fillRect(x, y, rand() % 40, rand() % 20, rand() % 3); break;
+            case 1: display.setPixel(x & 127, y & 63); break;
+            case 2: display.invertText(rand() & 1);
+                    labels.print(display, txtSettings, x, y); break;
+            case 3: display.print("AB", x & 127, y & 63); break;
+            case 4: if (rand() % 10 == 0) display.clrScr(); break;
+        }
+        if (rand() % 4 == 0) flush();
+    }
+    flush();
+    CHECK(hostPanelIsBuffer());
+}
+
+unsigned long stepBytes(int16_t detents) {
+    unsigned long bus = hostPanelBytes();
+
+    hostTurn(detents, 40000);
+    hostRun(200);
+    CHECK(hostPanelIsBuffer());
+    return hostPanelBytes() - bus;
+}
+
+// A navigation step costs what moved, not the screen
+void testSteps() {
+    invalidate(DIRTY_ALL);
+    hostRun(200);
+    CHECK(hostPanelIsBuffer());
+
+    // Main menu: the marker and the scrollbar handle
+    unsigned long main = stepBytes(1);
+    CHECK(main > 0);
+    CHECK(main < 400);
+    printf("main menu step: %lu bytes\n", main);
+
+    // Nothing moves, nothing is sent
+    CHECK_EQ(stepBytes(0), 0);
+
+    // Going back up costs the same
+    CHECK_EQ(stepBytes(-1), main);
+}
+
+void testValue() {
+    // DISPLAY > MENU LOOP, open
+    enterMenu(DISPLAY_MENU);
+    hostRun(200);
+    buttonPressed_i = 2;
+    hostRun(200);
+
+    // One detent: the value field only, two pages
+    unsigned long bus = hostPanelBytes();
+    events.push(EV_DETENT, 1, micros());
+    hostRun(200);
+    unsigned long value = hostPanelBytes() - bus;
+
+    CHECK(hostPanelIsBuffer());
+    CHECK(value > 0);
+    CHECK(value < 2 * (8 + 128 + 16));
+    printf("value step: %lu bytes\n", value);
+}
+
+int main() {
+    testSpans();
+    testRandom();
+    testSteps();
+    testValue();
+    return done("paged");
+}
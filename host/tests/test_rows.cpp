@@ -0,0 +1,191 @@
+// Selectable rows test - Angelo Z. (2025)
+
+/*
+  The cursor on a tree of its own, tree_rows.h: it stops only on
+  items, over runs of labels at the start, in the middle and at the
+  end, in a menu longer than the old 32 rows, with items hidden.
+  stepRow() is checked against a walk of the rows one by one.
+*/
+#define MENU_TREE "host/tests/tree_rows.h"
+
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// The selectable row after or before a row, one row at a time
+int8_t walk(int8_t row, int8_t dir) {
+    for (int8_t r = row + dir; r >= 0 && r < arrayLen; r += dir)
+        if (!isLabel(r)) return r;
+    return -1;
+}
+
+// Every row of the menu on screen against the walk
+void checkRows() {
+    CHECK_EQ(firstRow, walk(-1, 1));
+    CHECK_EQ(lastRow, walk(arrayLen, -1));
+
+    for (int8_t r = 0; r < arrayLen; r++) {
+        CHECK_EQ(stepRow(r, 1), walk(r, 1));
+        CHECK_EQ(stepRow(r, -1), walk(r, -1));
+    }
+}
+
+void down(int8_t row) {
+    cursorDown();
+    CHECK_EQ(cursor, row);
+}
+
+void up(int8_t row) {
+    cursorUp();
+    CHECK_EQ(cursor, row);
+}
+
+// L L A L L B C L D L L
+void testMain() {
+    setup();
+    hostRun(100);
+
+    CHECK_EQ(arrayLen, 11);
+    CHECK_EQ(firstRow, 2);
+    CHECK_EQ(lastRow, 8);
+    CHECK_EQ(cursor, 2);
+    checkRows();
+
+    loopMenu = false;
+    down(5);
+    down(6);
+    down(8);
+    down(8);
+    up(6);
+    up(5);
+    up(2);
+    up(2);
+
+    // Around the ends, over the labels
+    loopMenu = true;
+    up(8);
+    down(2);
+    loopMenu = false;
+
+    hostRun(100);
+    CHECK(hostPanelIsBuffer());
+}
+
+// 40 rows, runs of labels across the bytes of the masks
+void testLong() {
+    openLevel(LONG_MENU);
+    hostRun(100);
+
+    CHECK_EQ(arrayLen, 40);
+    CHECK_EQ(cursor, 10);
+    CHECK_EQ(lastRow, 33);
+    checkRows();
+
+    down(30);
+    down(31);
+    up(30);
+    up(10);
+
+    // Past the screen: the list scrolls to the row
+    down(30);
+    CHECK_EQ(rectY, screenEnd - 1);
+    CHECK_EQ(scroll, 30 - (screenEnd - 1));
+    hostRun(200);
+    CHECK(hostPanelIsBuffer());
+}
+
+// Hidden items move the rows, the masks follow
+void testHidden() {
+    srand(5);
+
+    for (int n = 0; n < 200; n++) {
+        const MenuItem *it = menuItem(LONG_MENU, rand() % 40);
+
+        setMask(it, Hide, rand() & 1);
+        buildRows();
+        checkRows();
+    }
+
+    for (uint8_t k = 0; k < 40; k++)
+        setMask(menuItem(LONG_MENU, k), Hide, false);
+    buildRows();
+    CHECK_EQ(arrayLen, 40);
+}
+
+// itemAt() of the cursor, its id
+uint8_t selected() {
+    return itemId(itemAt(cursor));
+}
+
+// Rows hidden and shown under the cursor: it stays on its item
+void testShowItem() {
+    openLevel(MAIN_MENU);
+    CHECK(treeInOrder());
+
+    // On A, a label above goes: A is a row up, not the label after it
+    CHECK_EQ(selected(), ITEM_A);
+    showItem(&main_menu[L0], false);
+    CHECK_EQ(cursor, 1);
+    CHECK_EQ(selected(), ITEM_A);
+
+    // On C, C goes: B and D are a row away, D takes its place
+    cursorDown();
+    cursorDown();
+    CHECK_EQ(selected(), ITEM_C);
+    showItem(&main_menu[ITEM_C], false);
+    CHECK_EQ(selected(), ITEM_D);
+    CHECK_EQ(cursor, 6);
+
+    // On D, the rows above come back
+    showItem(&main_menu[L0], true);
+    showItem(&main_menu[ITEM_C], true);
+    CHECK_EQ(selected(), ITEM_D);
+    CHECK_EQ(cursor, 8);
+
+    // On B, B goes: C takes its row
+    cursorUp();
+    cursorUp();
+    CHECK_EQ(selected(), ITEM_B);
+    showItem(&main_menu[ITEM_B], false);
+    CHECK_EQ(selected(), ITEM_C);
+    CHECK_EQ(cursor, 5);
+
+    // Nothing below: the nearest one above, over the labels
+    showItem(&main_menu[ITEM_D], false);
+    CHECK_EQ(selected(), ITEM_C);
+    showItem(&main_menu[ITEM_C], false);
+    CHECK_EQ(selected(), ITEM_A);
+    CHECK_EQ(cursor, 2);
+
+    for (uint8_t k = 0; k < LIST(main_menu); k++)
+        setMask(&main_menu[k], Hide, false);
+    openLevel(MAIN_MENU);
+    hostRun(100);
+    CHECK(hostPanelIsBuffer());
+}
+
+// Nothing to select: the cursor doesn't move
+void testLabelsOnly() {
+    openLevel(ALL_LABELS_MENU);
+
+    CHECK_EQ(firstRow, -1);
+    CHECK_EQ(lastRow, -1);
+    CHECK_EQ(cursor, 0);
+
+    loopMenu = true;
+    down(0);
+    up(0);
+    loopMenu = false;
+
+    hostRun(100);
+    CHECK(hostPanelIsBuffer());
+}
+
+int main() {
+    testMain();
+    testLong();
+    testHidden();
+    testShowItem();
+    testLabelsOnly();
+    return done("rows");
+}
@@ -0,0 +1,193 @@
+// Sliding bar test - Angelo Z. (2025)
+
+/*
+  SMOOTH_SCROLL on: the bar slides between the rows of DISPLAY, the
+  list of LONG under the bar. A frame sends only what the bar crosses
+  or the text columns, and fits in ANIM_PERIOD on a 400 kHz bus, every
+  frame on the glass is the buffer, and where the slide stops the
+  screen is what a full redraw draws. The tree is tree_slide.h.
+*/
+#define SMOOTH_SCROLL 1
+#define MENU_TREE "host/tests/tree_slide.h"
+
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// 9 clocks a byte at 400 kHz
+#define FRAME_BYTES (ANIM_PERIOD * 400000UL / 9 / 1000)
+
+// One detent, then the frames of the slide. The largest one.
+unsigned long slideBytes(int8_t dir, uint8_t &nFrames) {
+    unsigned long most = 0;
+    uint16_t updates = display.updates;
+
+    nFrames = 0;
+    events.push(EV_DETENT, dir, micros());
+
+    for (int ms = 0; ms < 300; ms++) {
+        unsigned long bus = hostPanelBytes();
+
+        hostRun(1);
+        if (display.updates != updates) {
+            updates = display.updates;
+            most = max(most, hostPanelBytes() - bus);
+            nFrames++;
+            CHECK(hostPanelIsBuffer());
+        }
+    }
+    CHECK_EQ(barSlide, 0);
+    return most;
+}
+
+// Where it stops, the slide left what a redraw draws
+void checkRest() {
+    static uint8_t slid[1024];
+
+    memcpy(slid, hostPanel(), sizeof(slid));
+    invalidate(DIRTY_ALL);
+    hostRun(100);
+    CHECK(memcmp(slid, hostPanel(), sizeof(slid)) == 0);
+}
+
+void testBar() {
+    uint8_t n;
+
+    setup();
+    hostRun(100);
+    enterMenu(DISPLAY_MENU);
+    hostRun(200);
+    CHECK_EQ(cursor, 0);
+
+    unsigned long most = slideBytes(1, n);
+    CHECK_EQ(cursor, 1);
+    CHECK(n >= MENU_H / ANIM_STEP);
+    CHECK(most < FRAME_BYTES);
+    printf("bar slide: %u frames, at most %lu bytes (%lu in %d ms)\n",
+           n, most, FRAME_BYTES, ANIM_PERIOD);
+    checkRest();
+
+    CHECK(slideBytes(1, n) < FRAME_BYTES);
+    CHECK_EQ(cursor, 2);
+    checkRest();
+
+    CHECK(slideBytes(-1, n) < FRAME_BYTES);
+    CHECK_EQ(cursor, 1);
+    checkRest();
+
+    // Two detents in a frame: a row at most is left to slide
+    events.push(EV_DETENT, 1, micros());
+    hostRun(4);
+    CHECK(slideBytes(-1, n) < FRAME_BYTES);
+    CHECK(hostPanelIsBuffer());
+    checkRest();
+}
+
+// CLOCK 0 scrolls: at rest its row is drawn selected again
+void testMarquee() {
+    uint8_t n;
+
+    leaveMenu();
+    hostRun(100);
+    enterMenu(SETTINGS_MENU);
+    hostRun(200);
+    CHECK_EQ(cursor, 0);
+
+    CHECK(slideBytes(1, n) < FRAME_BYTES);
+    CHECK_EQ(cursor, 1);
+    checkRest();
+
+    CHECK(slideBytes(-1, n) < FRAME_BYTES);
+    CHECK_EQ(cursor, 0);
+    CHECK_EQ(drawnBar, NO_BAR);
+    CHECK(hostPanelIsBuffer());
+}
+
+// 40 rows: down to the end and back, the list slides under the bar
+void testLong() {
+    unsigned long most = 0;
+    uint8_t n;
+
+    leaveMenu();
+    hostRun(100);
+    enterMenu(LONG_MENU);
+    hostRun(200);
+    CHECK_EQ(cursor, 0);
+
+    for (uint8_t k = 0; k < 30; k++) {
+        most = max(most, slideBytes(1, n));
+        if (k % 7 == 0) checkRest();
+    }
+    CHECK_EQ(itemId(itemAt(cursor)), LONG_FIRST + 38);
+    CHECK(scroll > 20);
+    checkRest();
+
+    for (uint8_t k = 0; k < 30; k++) {
+        most = max(most, slideBytes(-1, n));
+        if (k % 5 == 0) checkRest();
+    }
+    CHECK_EQ(cursor, 0);
+    checkRest();
+
+    // Two detents in a frame over the list
+    for (uint8_t k = 0; k < 8; k++) {
+        events.push(EV_DETENT, 1, micros());
+        hostRun(4);
+        most = max(most, slideBytes(1, n));
+    }
+    checkRest();
+
+    CHECK(most < FRAME_BYTES);
+    printf("list slide: at most %lu bytes (%lu in %d ms)\n",
+           most, FRAME_BYTES, ANIM_PERIOD);
+}
+
+// The last row of the panel, y = 63: bit 7 of page 7
+boolean bottomLine(boolean lit) {
+    const uint8_t *page = hostPanel() + 7 * OLED_COLS;
+
+    for (uint8_t x = 0; x < OLED_COLS; x++)
+        if (((page[x] & 0x80) != 0) != lit) return false;
+    return true;
+}
+
+// A save draws its progress on y = 63, over the bar of the 4th row:
+// when it's over the bar has its bottom line again
+void testProgress() {
+    uint8_t n;
+
+    leaveMenu();
+    hostRun(100);
+    enterMenu(LONG_MENU);
+    hostRun(200);
+    for (uint8_t k = 0; k < 3; k++) slideBytes(1, n);
+    CHECK_EQ(cursor, 4);
+    CHECK_EQ(rectY, 3);
+    CHECK(bottomLine(true));
+
+    itemFlags[LONG_FIRST] |= Modified;
+    saveData(NULL);
+    hostRun(1);
+    CHECK(scheduler.pending(commitData));
+    while (scheduler.pending(commitData)) hostRun(1);
+    hostRun(100);
+    CHECK(bottomLine(true));
+    checkRest();
+
+    // On the first row the line is background
+    for (uint8_t k = 0; k < 3; k++) slideBytes(-1, n);
+    CHECK_EQ(rectY, 0);
+    saveData(NULL);
+    while (scheduler.pending(commitData)) hostRun(1);
+    hostRun(100);
+    CHECK(bottomLine(false));
+    checkRest();
+}
+
+int main() {
+    testBar();
+    testMarquee();
+    testLong();
+    testProgress();
+    return done("slide");
+}
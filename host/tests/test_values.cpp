@@ -0,0 +1,144 @@
+// Value burst test - Angelo Z. (2025)
+
+/*
+  1000 detents on the pins while the main loop is busy: the value
+  takes all of them at once, lands on the exact value or on its limit,
+  and is drawn once. The tree is tree_values.h.
+*/
+#define MENU_TREE "host/tests/tree_values.h"
+
+#include "check.h"
+#include "host.h"
+#include "../../menu.cpp"
+
+// A burst between two passes of loop(), then the frames it costs
+unsigned long burst(int16_t detents, unsigned long usPerDetent) {
+    unsigned long f = frames;
+
+    hostTurn(detents, usPerDetent, 1);
+    hostRun(200);
+    CHECK_EQ(encoder.invalid, 0);
+    CHECK_EQ(events.dropped, 0);
+    CHECK(hostPanelIsBuffer());
+    return frames - f;
+}
+
+void testCount() {
+    setup();
+    hostRun(100);
+
+    // VALUES > COUNT, open
+    hostClick();
+    CHECK_EQ(indexMenu, VALUES_MENU);
+    hostClick();
+    CHECK(rotary_accel);
+
+    // Fast: a detent each 200 us, a step of one
+    CHECK_EQ(burst(1000, 200), 1);
+    CHECK_EQ(values[VAL_COUNT], 1000);
+
+    CHECK_EQ(burst(-1000, 200), 1);
+    CHECK_EQ(values[VAL_COUNT], 0);
+
+    // Past the limits
+    CHECK_EQ(burst(-1000, 200), 1);
+    CHECK_EQ(values[VAL_COUNT], 0);
+    values[VAL_COUNT] = 99500;
+    CHECK_EQ(burst(1000, 200), 1);
+    CHECK_EQ(values[VAL_COUNT], 100000);
+
+    // Spread over 25 frames: the frames bound the redraws
+    unsigned long f = frames;
+    values[VAL_COUNT] = 0;
+    for (uint8_t n = 0; n < 25; n++) {
+        hostTurn(40, 1000, 1);
+        hostRun(1);
+    }
+    hostRun(200);
+    CHECK_EQ(values[VAL_COUNT], 1000);
+    CHECK(frames - f <= 25 + 1);
+    CHECK(hostPanelIsBuffer());
+
+    hostClick();
+    CHECK(!rotary_accel);
+}
+
+// A decade step, slow detents: every detent a step of one
+void testSlow() {
+    hostTurn(1, 40000);
+    hostRun(200);
+    CHECK_EQ(cursor, 1);
+    hostClick();
+    CHECK(rotary_accel);
+
+    CHECK_EQ(burst(1000, 2000UL * ACCEL_SLOW), 1);
+    CHECK_EQ(values[VAL_CLOCK], 9000);
+
+    // Fast: the first digit of the range, down to the limit
+    CHECK_EQ(burst(-1000, 200), 1);
+    CHECK_EQ(values[VAL_CLOCK], 8000);
+    CHECK_EQ(burst(1000, 200), 1);
+    CHECK_EQ(values[VAL_CLOCK], 160000000);
+}
+
+// Below zero the step stays on the digit too. Two detents 40 ms apart
+// in a frame, a step of 100 on five digits: the first to the digit,
+// the second one step on
+void testNegative() {
+    hostClick();
+    CHECK(!rotary_accel);
+    hostTurn(1, 40000);
+    hostRun(200);
+    CHECK_EQ(cursor, 2);
+    hostClick();
+    CHECK(rotary_accel);
+
+    values[VAL_OFFSET] = -12345;
+    hostTurn(2, 40000);
+    hostRun(200);
+    CHECK_EQ(values[VAL_OFFSET], -12200);
+
+    values[VAL_OFFSET] = -12345;
+    hostTurn(-2, 40000);
+    hostRun(200);
+    CHECK_EQ(values[VAL_OFFSET], -12500);
+
+    // Across zero and on to the limit
+    values[VAL_OFFSET] = -150;
+    hostTurn(2, 40000);
+    hostRun(200);
+    CHECK_EQ(values[VAL_OFFSET], 0);
+    CHECK(burst(-1000, 200) <= 1);
+    CHECK_EQ(values[VAL_OFFSET], -99999);
+    CHECK(hostPanelIsBuffer());
+}
+
+// The longest values in FORMAT_SIZE, for every format
+void testFormat() {
+    // A long of the AVR
+    const int32_t extremes[] = { INT32_MIN, INT32_MAX, -1, 0, 999, -100000 };
+    char buf[FORMAT_SIZE + 8];
+
+    for (uint8_t e = 0; e < LIST(extremes); e++) {
+        for (uint16_t f = 0; f < 0xfe; f++) {
+            if ((f & 8) || (f >> 4) >= N_UNITS) continue;
+            memset(buf, '#', sizeof(buf));
+
+            uint8_t w = formatValue(buf, extremes[e], f, FONT_W);
+            CHECK(strlen(buf) < FORMAT_SIZE);
+            CHECK_EQ(w, strlen(buf) * FONT_W);
+            CHECK_EQ(buf[FORMAT_SIZE], '#');
+        }
+    }
+
+    formatValue(buf, INT32_MIN, FMT_GROUP | FMT_UNIT(UNIT_HZ), FONT_W);
+    CHECK(!strcmp(buf, "-2,147,483,648Hz"));
+}
+
+int main() {
+    testFormat();
+    testCount();
+    testSlow();
+    testNegative();
+    return done("values");
+}
@@ -0,0 +1,80 @@
+// Test tree - Angelo Z. (2025)
+
+/*
+  A menu tree for test_rows, included by menu.cpp through MENU_TREE.
+  Runs of labels at the start, in the middle and at the end of a menu,
+  and a menu longer than a byte of the masks many times over.
+
+    MAIN_MENU   L L A L L B C L D L L
+    LONG_MENU   10 labels, 1 item, 19 labels, 4 items, 6 labels
+*/
+
+enum {
+    MAIN_MENU,
+    OPTIONS_MENU,
+    LONG_MENU,
+    ALL_LABELS_MENU,
+    N_MENUS
+};
+
+enum {
+    L0, L1, ITEM_A, L2, L3, ITEM_B, ITEM_C, L4, ITEM_D, L5, L6,
+    MENU_LOOP, KEY_TONE,
+    LONG_FIRST, LONG_LAST = LONG_FIRST + 39,
+    ONLY_LABEL_0, ONLY_LABEL_1,
+    N_ITEMS
+};
+
+enum {
+    VAL_MENU_LOOP, VAL_KEY_TONE,
+    N_VALUES
+};
+
+const char txtLabel[] PROGMEM = "LABEL";
+const char txtItem[] PROGMEM = "ITEM";
+const char txtNone[] PROGMEM = "";
+
+#define LABEL(id) { txtLabel, 0, 0, 0, NULL, Label, id }
+#define BUTTON(id) { txtItem, 0, 0, 0, leaveMenu, Button, id }
+
+const MenuItem main_menu[] PROGMEM = {
+    LABEL(L0), LABEL(L1), BUTTON(ITEM_A), LABEL(L2), LABEL(L3),
+    BUTTON(ITEM_B), BUTTON(ITEM_C), LABEL(L4), BUTTON(ITEM_D),
+    LABEL(L5), LABEL(L6)
+};
+
+const MenuItem options_menu[] PROGMEM = {
+    { txtItem, 0, 0, 1, option, Item | YesNo, MENU_LOOP, 0, VAL_MENU_LOOP },
+    { txtItem, 0, 0, 1, option, Item | YesNo, KEY_TONE, 0, VAL_KEY_TONE }
+};
+
+#define LONG_L(k) LABEL(LONG_FIRST + k)
+#define LONG_B(k) BUTTON(LONG_FIRST + k)
+
+const MenuItem long_menu[] PROGMEM = {
+    LONG_L(0), LONG_L(1), LONG_L(2), LONG_L(3), LONG_L(4),
+    LONG_L(5), LONG_L(6), LONG_L(7), LONG_L(8), LONG_L(9),
+    LONG_B(10),
+    LONG_L(11), LONG_L(12), LONG_L(13), LONG_L(14), LONG_L(15),
+    LONG_L(16), LONG_L(17), LONG_L(18), LONG_L(19), LONG_L(20),
+    LONG_L(21), LONG_L(22), LONG_L(23), LONG_L(24), LONG_L(25),
+    LONG_L(26), LONG_L(27), LONG_L(28), LONG_L(29),
+    LONG_B(30), LONG_B(31), LONG_B(32), LONG_B(33),
+    LONG_L(34), LONG_L(35), LONG_L(36), LONG_L(37), LONG_L(38),
+    LONG_L(39)
+};
+
+const MenuItem all_labels_menu[] PROGMEM = {
+    LABEL(ONLY_LABEL_0), LABEL(ONLY_LABEL_1)
+};
+
+const Menu menus[] PROGMEM = {
+    { txtNone, main_menu, LIST(main_menu) },
+    { txtNone, options_menu, LIST(options_menu) },
+    { txtNone, long_menu, LIST(long_menu) },
+    { txtNone, all_labels_menu, LIST(all_labels_menu) }
+};
+
+static_assert(LIST(main_menu) + LIST(options_menu) + LIST(long_menu)
+              + LIST(all_labels_menu) == N_ITEMS,
+              "Every item needs its own id");
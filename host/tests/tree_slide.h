@@ -0,0 +1,81 @@
+// Test tree - Angelo Z. (2025)
+
+/*
+  A menu tree for test_slide, included by menu.cpp through MENU_TREE.
+  DISPLAY and SETTINGS as in the sketch, and a menu of 40 rows with
+  values and labels for the list to slide over.
+
+    LONG_MENU   V V V L, ten times
+*/
+
+enum {
+    MAIN_MENU,
+    SETTINGS_MENU,
+    DISPLAY_MENU,
+    LONG_MENU,
+    N_MENUS
+};
+
+enum {
+    SETTINGS_ITEM, DISPLAY_ITEM, LONG_ITEM,
+    CLOCK_0, SETTINGS_BACK,
+    MENU_LOOP, KEY_TONE, DISPLAY_BACK,
+    LONG_FIRST, LONG_LAST = LONG_FIRST + 39,
+    N_ITEMS
+};
+
+// Three values in each four rows of LONG
+enum {
+    VAL_CLOCK_0, VAL_MENU_LOOP, VAL_KEY_TONE,
+    VAL_LONG, VAL_LONG_LAST = VAL_LONG + 29,
+    N_VALUES
+};
+
+const char txtClock0[] PROGMEM = "CLOCK 0";
+const char txtBack[] PROGMEM = "<-";
+const char txtMenuLoop[] PROGMEM = "MENU LOOP";
+const char txtKeyTone[] PROGMEM = "KEY TONE";
+const char txtSettings[] PROGMEM = "SETTINGS";
+const char txtDisplay[] PROGMEM = "DISPLAY";
+const char txtLong[] PROGMEM = "LONG";
+const char txtItem[] PROGMEM = "ITEM";
+const char txtLabel[] PROGMEM = "LABEL";
+const char txtNone[] PROGMEM = "";
+
+const MenuItem main_menu[] PROGMEM = {
+    { txtSettings, 0, 0, 0, NULL, Submenu, SETTINGS_ITEM, 0, SETTINGS_MENU },
+    { txtDisplay, 0, 0, 0, NULL, Submenu, DISPLAY_ITEM, 0, DISPLAY_MENU },
+    { txtLong, 0, 0, 0, NULL, Submenu, LONG_ITEM, 0, LONG_MENU }
+};
+
+const MenuItem settings_menu[] PROGMEM = {
+    { txtClock0, 8000, 8000, 160000000, option, Item | Scrolling, CLOCK_0, 0, VAL_CLOCK_0, ACCEL_DECADE, FMT_GROUP },
+    { txtBack, 0, 0, 0, leaveMenu, Button, SETTINGS_BACK }
+};
+
+const MenuItem display_menu[] PROGMEM = {
+    { txtMenuLoop, 0, 0, 1, option, Item | YesNo, MENU_LOOP, 0, VAL_MENU_LOOP },
+    { txtKeyTone, 0, 0, 1, option, Item | YesNo, KEY_TONE, 0, VAL_KEY_TONE },
+    { txtBack, 0, 0, 0, leaveMenu, Button, DISPLAY_BACK }
+};
+
+#define LONG_V(k) { txtItem, k, 0, 99, option, Item, LONG_FIRST + k, 0, \
+                    VAL_LONG + (k) / 4 * 3 + (k) % 4 }
+#define LONG_L(k) { txtLabel, 0, 0, 0, NULL, Label, LONG_FIRST + k }
+#define LONG_4(k) LONG_V(k), LONG_V(k + 1), LONG_V(k + 2), LONG_L(k + 3)
+
+const MenuItem long_menu[] PROGMEM = {
+    LONG_4(0), LONG_4(4), LONG_4(8), LONG_4(12), LONG_4(16),
+    LONG_4(20), LONG_4(24), LONG_4(28), LONG_4(32), LONG_4(36)
+};
+
+const Menu menus[] PROGMEM = {
+    { txtNone, main_menu, LIST(main_menu) },
+    { txtSettings, settings_menu, LIST(settings_menu) },
+    { txtDisplay, display_menu, LIST(display_menu) },
+    { txtLong, long_menu, LIST(long_menu) }
+};
+
+static_assert(LIST(main_menu) + LIST(settings_menu) + LIST(display_menu)
+              + LIST(long_menu) == N_ITEMS,
+              "Every item needs its own id");
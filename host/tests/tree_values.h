@@ -0,0 +1,51 @@
+// Test tree - Angelo Z. (2025)
+
+/*
+  A menu tree for test_values, included by menu.cpp through MENU_TREE:
+  values edited on the OLED with a wide range, one for each kind of
+  step, and a decade step across zero.
+*/
+
+enum {
+    MAIN_MENU,
+    VALUES_MENU,
+    N_MENUS
+};
+
+enum {
+    VALUES_ITEM,
+    COUNT, CLOCK, OFFSET, MENU_LOOP, KEY_TONE,
+    N_ITEMS
+};
+
+enum {
+    VAL_COUNT, VAL_CLOCK, VAL_OFFSET, VAL_MENU_LOOP, VAL_KEY_TONE,
+    N_VALUES
+};
+
+const char txtValues[] PROGMEM = "VALUES";
+const char txtCount[] PROGMEM = "COUNT";
+const char txtClock[] PROGMEM = "CLOCK";
+const char txtOffset[] PROGMEM = "OFFSET";
+const char txtOption[] PROGMEM = "OPTION";
+const char txtNone[] PROGMEM = "";
+
+const MenuItem main_menu[] PROGMEM = {
+    { txtValues, 0, 0, 0, NULL, Submenu, VALUES_ITEM, 0, VALUES_MENU }
+};
+
+const MenuItem values_menu[] PROGMEM = {
+    { txtCount, 0, 0, 100000, option, Item, COUNT, 0, VAL_COUNT, ACCEL_NONE },
+    { txtClock, 8000, 8000, 160000000, option, Item, CLOCK, 0, VAL_CLOCK, ACCEL_DECADE, FMT_GROUP },
+    { txtOffset, 0, -99999, 99999, option, Item, OFFSET, 0, VAL_OFFSET, ACCEL_DECADE },
+    { txtOption, 0, 0, 1, option, Item | YesNo, MENU_LOOP, 0, VAL_MENU_LOOP },
+    { txtOption, 0, 0, 1, option, Item | YesNo, KEY_TONE, 0, VAL_KEY_TONE }
+};
+
+const Menu menus[] PROGMEM = {
+    { txtNone, main_menu, LIST(main_menu) },
+    { txtValues, values_menu, LIST(values_menu) }
+};
+
+static_assert(LIST(main_menu) + LIST(values_menu) == N_ITEMS,
+              "Every item needs its own id");
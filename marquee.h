@@ -0,0 +1,98 @@
+// Marquee - Angelo Z. (2025)
+
+/*
+  Scrolling label of the selected item.
+
+  The label is rasterized once by the text cache. Every step moves it
+  by a few pixels and redraws only the text area of its row, the
+  other rows are not touched.
+
+      period = len + width
+      pos    0 ......... len ........ period
+             [TEXT      ]  [          ]
+             [EXT       ]  leaves on the left
+             [          ]  gone
+             [        TE]  comes back from the right
+
+  The SSD1306 hardware scroll moves whole pages over the full width,
+  margin and scrollbar too, and the panel drifts from the buffer: so
+  the scrolling is done in the buffer.
+*/
+#ifndef MARQUEE_H
+#define MARQUEE_H
+
+#include <Arduino.h>
+#include "framebuffer.h"
+#include "textcache.h"
+
+
+class Marquee {
+public:
+    Marquee() {
+        text = NULL;
+        pos = 0;
+    }
+
+    // Back to the start, with the next step
+    void reset() {
+        text = NULL;
+        pos = 0;
+    }
+
+    /*
+    =====================
+     boolean step
+    =====================
+    */
+    // Move by px pixels and draw
+    boolean step(PagedOLED &display, TextCache &cache, const char *label,
+                 int x, int y, int width, uint8_t px) {
+        if (label == text) pos += px;
+        return draw(display, cache, label, x, y, width);
+    }
+
+    /*
+    =====================
+     boolean draw
+    =====================
+    */
+    // The text at the current position, inverted as the selection bar.
+    // Another label starts from the beginning. False if the label is
+    // too long for the cache and nothing was drawn.
+    boolean draw(PagedOLED &display, TextCache &cache, const char *label,
+              int x, int y, int width) {
+        uint8_t len;
+        const uint8_t *cols = cache.columns(display, label, len);
+
+        if (label != text) {
+            text = label;
+            pos = 0;
+        }
+
+        // Too long for the cache
+        if (cols == NULL) return false;
+
+        int period = len + width;
+        if (pos >= period) pos -= period;
+
+        // Gap columns
+        display.fillRect(x, y, width, 8, FILL_SET);
+
+        // Leaving on the left
+        if (pos < len)
+            display.blit(cols + pos, min(len - pos, width), x, y, true);
+
+        // Coming from the right
+        int from = period - pos;
+        if (from < width)
+            display.blit(cols, min((int) len, width - from), x + from, y, true);
+
+        return true;
+    }
+
+protected:
+    const char *text;   // In flash
+    int pos;            // Pixels
+};
+
+#endif
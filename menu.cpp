@@ -15,8 +15,8 @@
       scroll++ = Menu[scroll, items]
 
     
-      I use ClickEncoder library only for the rotary encoder and
-      disabled the button due the timing response in menu
+      The rotary encoder is decoded by the interrupts of its pins,
+      see encoder.h
       
       For the button
       
@@ -24,19 +24,61 @@
             buttonaReleased
             buttonHold
             buttonClicked
+            buttonDoubleClicked
+            buttonRepeat
+
+      debounced in timerIsr, see button.h. Timer1 runs only from an
+      edge of the button until it is released and settled.
+
+    RAM, .data + .bss of the release build counted by hand (no
+    avr-size here), of the 2048 bytes of the ATmega328P
+
+      scrbuf + PagedOLED   1081     i2c, pushButton, encoder   55
+      labels                131     editor, lcdTarget, lcd     48
+      previews              105     values, flags, levels      41
+      events                 52     scalars, strings          ~120
+      scheduler              48     Wire + twi, core, Timer1  ~210
+
+      about 1890 bytes: 150 left for the stack. Serial is in the
+      DEBUG_STATS and BENCHMARK builds only.
 
     ItemAttributes Label e Button non sono Items
                 
 */
-#define FirstRun 0  // Prepare eeprom
+// Build flags, host/Makefile sets them with -D
+#ifndef DEBUG_STATS
+#define DEBUG_STATS 0  // Print counters on Serial
+#endif
+#ifndef REPLAY
+#define REPLAY 0       // Play inputScript[] instead of encoder and button
+#endif
+#ifndef BENCHMARK
+#define BENCHMARK 0    // Measure the menu operations at startup
+#endif
+#ifndef SMOOTH_SCROLL
+#define SMOOTH_SCROLL 0  // Slide the list instead of jumping a row
+#endif
+// A task for each job the build schedules: window, scrollText,
+// animate, commitData, lampOff, powerOnNote, and the debug ones
+#define MAX_TASKS (6 + DEBUG_STATS + REPLAY)
+#define TASK_STATS DEBUG_STATS
 #include <Arduino.h>
 #include <LiquidCrystal_I2C.h>
-#include <ClickEncoder.h>
 #include <TimerOne.h>
 #include <OLED_I2C.h>
 
 #include "eeprom.h"
 #include "menu.h"
+#include "framebuffer.h"
+#include "scheduler.h"
+#include "events.h"
+#include "button.h"
+#include "encoder.h"
+#include "bus.h"
+#include "textcache.h"
+#include "marquee.h"
+#include "format.h"
+#include "numedit.h"
 
 #define LIST(x) (sizeof(x) / sizeof(x[0]))
 
@@ -58,14 +100,27 @@
 #define SCR_HEIGHT 64
 #define MARGIN_L 5
 #define MARGIN_R SCR_WIDTH
+#define TEXT_END (MARGIN_R - MARGIN_L)   // Right edge of the values
 #define BUTTON_HOLDTIME 2000
-#define SCROLL_DELAY 10
+#define SCROLL_DELAY 20    // Scrolling text, ms for each step
+#define SCROLL_STEP 2      // Scrolling text, pixels for each step
+#define FRAME_PERIOD 40    // Input and redraw, ms
+#define ANIM_PERIOD 10     // Sliding list, ms for each frame
+#define ANIM_STEP 4        // Sliding list, pixels for each frame
 
 // ----------------------------------------------------------------------------
 // Encoder 
 #define PushButtonPin   PINB0
+#define EncoderPinA     2    // INT0
+#define EncoderPinB     3    // INT1
 #define StepsPerNotch   4
-ClickEncoder *encoder;
+#define ACCEL_SLOW      120  // ms between detents, slower is a step of one
+#define ACCEL_LEVELS    5
+EventQueue events;
+QuadratureDecoder encoder(StepsPerNotch);
+DebouncedButton pushButton(BUTTON_HOLDTIME);
+volatile boolean sampling = true;
+uint8_t gesturesSeen = 0;
 int8_t buttonPressed_i = 0;
 boolean rotary_accel = false;
 boolean rotary_off = false;
@@ -79,140 +134,400 @@ int8_t startY = 0;
 int8_t scroll = 0;
 int8_t cursor = 0;
 int8_t rectY = 0;
-int8_t _cr = 0, _ry = 0, _sl = 0;
+// Pixels from their place while sliding, at most one row
+int8_t listSlide = 0;
+int8_t barSlide = 0;
+// Value on screen of the open item, -1 = the row is not drawn yet
+int8_t valueX = -1;
+uint8_t valueW = 0;
 
 // ----------------------------------------------------------------------------
 // Item Scrolling text
 //
-#define BUFSIZE (int) (SCR_WIDTH / FONT_W) - 1
-char rectbuf[BUFSIZE+1];
-int8_t head = 0, tail = 0;
-int8_t direction = 0;
-int8_t offset = BUFSIZE;
+#define SCROLL_X MARGIN_L
+#define SCROLL_W (SCR_WIDTH - 2 * MARGIN_L)
 
 // ----------------------------------------------------------------------------
-#define MAX_ITEMS 6
 #define PiezoPin 12
-boolean redraw = true;
+boolean redraw = true;  // false: keep what's on the screen
 boolean loopMenu = false;
 boolean speakerOn = false;
-boolean inMenu = true;
+
+// ----------------------------------------------------------------------------
+// What has to be redrawn
+//
+#define DIRTY_CURSOR   1  // Selection moved, same rows on screen
+#define DIRTY_SCROLL   2  // Rows shifted
+#define DIRTY_VALUE    4  // Value of the selected item
+#define DIRTY_LIST    16  // Another menu
+#define DIRTY_ALL     0x17
+
+uint8_t dirty = DIRTY_ALL;
+int8_t drawnCursor = 0;
+// Rows of drawnTop on screen in their place and plain, the bar
+// inverted over them at drawnBar. NO_BAR: the cursor row is selected.
+// drawnTop -1 and a bar: the rows are between two places.
+#define NO_BAR -128
+int8_t drawnTop = -1;
+int8_t drawnBar = NO_BAR;
+// Columns with text on screen: labels up to drawnLabels, values from
+// drawnValues. Outside them the rows are only background.
+uint8_t drawnLabels = MARGIN_L;
+uint8_t drawnValues = TEXT_END;
+// Statistics
+unsigned long frames = 0, passes = 0;
+
+void invalidate(uint8_t what) {
+    dirty |= what;
+}
+
+Scheduler scheduler;
+void scrollText();
+int16_t rotaryDelta();
+uint16_t detentInterval();
+void stepValue(int16_t detents);
+void commitData();
+void openLevel(uint8_t m);
+void moveCursor(int8_t to);
+void slide(int8_t rows, int8_t bars);
+void drawText(int8_t i, int y, boolean selected);
+void animate();
+void printStat(const char *name, unsigned long value);
 
 LiquidCrystal_I2C lcd = LiquidCrystal_I2C(0x27, 16, 2);
 
-OLED display(SDA, SCL);
+PagedOLED display(SDA, SCL);
+TextCache labels;
+ValueCache previews;
+Marquee marquee;
+I2CBus i2c;
+
+void flushScreen() {
+    display.update();
+}
+
+// The flush runs with the other jobs of the screen channel
+void updateScreen() {
+    i2c.post(__SCREEN__I2C, flushScreen);
+}
 extern uint8_t SmallFont[];
 
 // ----------------------------------------------------------------------------
 // Items flags
 //
 typedef enum {
-    Item         =  1, 
-    Button       =  2,
-    Label        =  4,
-    OnOff        =  8,
-    YesNo        = 16,
-    Hide         = 32,
-    Protected    = 64,
-    Scrolling    = 128
+    // Runtime, in RAM
+    Hide         =   1,
+    Protected    =   2,
+    Modified     =   4,  // val not saved yet
+    // Static, in flash
+    Item         =   8, 
+    Button       =  16,
+    Label        =  32,
+    OnOff        =  64,
+    YesNo        = 128,
+    Scrolling    = 256,
+    Submenu      = 512   // Opens menus[sub]
 } ItemAttributes;
 
+#define RUNTIME_FLAGS (Hide | Protected | Modified)
+
+// How fast turns scale the value step
+typedef enum {
+    ACCEL_NONE,     // One for each detent
+    ACCEL_LOG,      // A share of the value: any decade in the same turns
+    ACCEL_DECADE    // A power of ten, more digits left the faster
+} AccelProfile;
+
+// The menu tree is constant and lives in flash (PROGMEM). Only the
+// runtime flags of each item are in RAM, indexed by the item id, and
+// the values of the items that have one, indexed by their own value
+// identifier: buttons, submenus and labels take no 4 bytes.
 typedef struct {
-    const char *text;
-    long val,
+    const char *text;   // In flash
+    long def,           // Power on value
          min,
          max;
     void (*action)(void); 
-    ItemAttributes properties;
+    uint16_t properties;
+    uint8_t id;         // itemFlags[] and the masks
+    uint8_t key;        // Eeprom journal, 0 = not saved
+    uint8_t index;      // Submenu: menus[]. With a value: values[]
+    uint8_t accel;      // AccelProfile of the value
+    uint8_t format;     // FMT_ flags, see format.h
 } MenuItem;
 
 typedef struct {
-    const char *text;
-    MenuItem *item;
-    size_t items;
+    const char *text;   // In flash
+    const MenuItem *item;
+    uint8_t items;
 } Menu;
 
 // ----------------------------------------------------------------------------
-// List of items of an opened menu
-MenuItem *itemsList[MAX_ITEMS];
-int8_t indexMenu = 0;
-int8_t arrayLen = 0;
-
-// Items identifier 
-#define LOOP  0
-#define SOUND 1
-
-//----------------------------------------------------------------------------
-MenuItem hardware_configuration[] = {
-    { "CLOCK 0", 8000, 8000, 160000000, _lcd, Item | Scrolling | Protected },
-    { "<-", 0, 0, 0, leaveMenu, Button }
+// The menu tree
+//
+// MENU_TREE names a header with another tree, the host tests build
+// their own menus with it. It has the same names: the menus, items
+// and values identifiers, MAIN_MENU, MENU_LOOP, KEY_TONE, VAL_MENU_LOOP,
+// VAL_KEY_TONE, and menus[].
+#ifdef MENU_TREE
+#include MENU_TREE
+#else
+
+// Menus identifier, the index in menus[]
+enum {
+    MAIN_MENU,
+    SETTINGS_MENU,
+    DISPLAY_MENU,
+    N_MENUS
 };
 
-MenuItem software_configuration[] = {
-    { "MENU LOOP", 0, 0, 1, option, Item | YesNo },
-    { "KEY TONE", 0, 0, 1, option, Item | YesNo },
-    { "<-", 0, 0, 0, leaveMenu, Button }
+// Items identifier, in the order of the tree: the items of a menu
+// are a run of consecutive ids. shown[] and selectable[] are read
+// from the id of the first item of the menu on, so an id out of its
+// run moves rows to another menu; treeInOrder() checks it.
+enum {
+    SETTINGS_ITEM, DISPLAY_ITEM, SAVE_BUTTON, EXIT_BUTTON,
+    CLOCK_0, SETTINGS_BACK,
+    MENU_LOOP, KEY_TONE, DISPLAY_BACK,
+    N_ITEMS
 };
 
+// Values identifier, the index in values[]: only the items with a
+// value, see hasValue()
+enum {
+    VAL_CLOCK_0, VAL_MENU_LOOP, VAL_KEY_TONE,
+    N_VALUES
+};
 
-MenuItem upload_to_eeprom = {
-    "", 0, 0, 0, storeData, Button
+const char txtClock0[] PROGMEM = "CLOCK 0";
+const char txtBack[] PROGMEM = "<-";
+const char txtMenuLoop[] PROGMEM = "MENU LOOP";
+const char txtKeyTone[] PROGMEM = "KEY TONE";
+const char txtNone[] PROGMEM = "";
+const char txtSettings[] PROGMEM = "SETTINGS";
+const char txtDisplay[] PROGMEM = "DISPLAY";
+const char txtSave[] PROGMEM = "SAVE";
+const char txtExit[] PROGMEM = "EXIT";
+
+const MenuItem main_menu[] PROGMEM = {
+    { txtSettings, 0, 0, 0, NULL, Submenu, SETTINGS_ITEM, 0, SETTINGS_MENU },
+    { txtDisplay, 0, 0, 0, NULL, Submenu, DISPLAY_ITEM, 0, DISPLAY_MENU },
+    { txtSave, 0, 0, 0, storeData, Button, SAVE_BUTTON },
+    { txtExit, 0, 0, 0, exitMain, Button, EXIT_BUTTON }
 };
 
+const MenuItem hardware_configuration[] PROGMEM = {
+    { txtClock0, 8000, 8000, 160000000, _lcd, Item | Scrolling | Protected, CLOCK_0, 1, VAL_CLOCK_0, ACCEL_DECADE, FMT_GROUP },
+    { txtBack, 0, 0, 0, leaveMenu, Button, SETTINGS_BACK }
+};
 
-MenuItem noMenu = {
-    "", 0, 0, 0, exitMain, Button
+const MenuItem software_configuration[] PROGMEM = {
+    { txtMenuLoop, 0, 0, 1, option, Item | YesNo, MENU_LOOP, 2, VAL_MENU_LOOP },
+    { txtKeyTone, 0, 0, 1, option, Item | YesNo, KEY_TONE, 3, VAL_KEY_TONE },
+    { txtBack, 0, 0, 0, leaveMenu, Button, DISPLAY_BACK }
 };
 
-Menu menus[] = {
-    { "SETTINGS", hardware_configuration, 2 }, // Items
-    { "DISPLAY", software_configuration, 3 }, // Items
-    { "SAVE", &upload_to_eeprom, 1 }, // Button
-    { "EXIT", &noMenu, 1 } // Button
+// Every level of the tree, in the order of the menus identifier
+const Menu menus[] PROGMEM = {
+    { txtNone, main_menu, LIST(main_menu) },
+    { txtSettings, hardware_configuration, LIST(hardware_configuration) },
+    { txtDisplay, software_configuration, LIST(software_configuration) }
 };
+
+static_assert(LIST(main_menu) + LIST(hardware_configuration)
+              + LIST(software_configuration) == N_ITEMS,
+              "Every item needs its own id");
+#endif
+
+static_assert(LIST(menus) == N_MENUS, "One entry for each menu id");
+
+long values[N_VALUES];
+uint8_t itemFlags[N_ITEMS];
+
+// Visible items, one bit for each id. It follows Hide, so the rows of
+// a menu are found without reading its items. selectable[] is the
+// same less the labels: where the cursor can stop.
+//
+//   id           0 1 2 3 4 5 6 7   8 ...
+//   shown      [ 1 1 0 1 1 1 1 1 | 1 ... ]   item 2 hidden
+//   selectable [ 0 1 0 1 1 0 0 1 | 1 ... ]   0, 5, 6 labels
+uint8_t shown[(N_ITEMS + 7) / 8];
+uint8_t selectable[(N_ITEMS + 7) / 8];
+
+boolean hasMask(const MenuItem *it, ItemAttributes attr);
+
 // ----------------------------------------------------------------------------
+// Navigation stack
+//
+//   levels[0]  MAIN      cursor 1   <- saved when SETTINGS opened
+//   levels[1]  SETTINGS  cursor 0   <- saved when ADVANCED opened
+//              ADVANCED             <- indexMenu, cursor, rectY, scroll
+//
+// Entering a submenu pushes the cursor of the current level, leaving
+// it pops it back. Nothing is copied from the tree.
+#define MAX_DEPTH 4
 
-void (* Reset_AVR)(void) = 0;
+typedef struct {
+    uint8_t menu;
+    int8_t cursor, rectY, scroll;
+} Level;
 
-void checkMe() {
-    loopMenu = software_configuration[LOOP].val;
-    speakerOn = software_configuration[SOUND].val;
+Level levels[MAX_DEPTH];
+uint8_t depth = 0;     // 0 = main menu
+int8_t indexMenu = 0;  // Menu on screen
+int8_t arrayLen = 0;   // Its visible items
+
+// ----------------------------------------------------------------------------
+// Selectable rows of the menu on screen
+//
+// A move looks for the next id in selectable[] and counts the ids of
+// shown[] on the way, eight at a time: no table to size, whatever the
+// length of the menu.
+int8_t firstRow = -1, lastRow = -1;  // -1 = nothing to select
+
+const MenuItem *itemAt(int8_t pos);
+
+// ----------------------------------------------------------------------------
+// Flash access
+//
+inline const char *menuText(uint8_t i) {
+    return (const char *) pgm_read_ptr(&menus[i].text);
 }
 
+inline uint8_t menuItems(uint8_t i) {
+    return pgm_read_byte(&menus[i].items);
+}
 
-#define N_DIGITS 9
-#define OK 0x7e
-#define LEAVE 0x7f
+inline const MenuItem *menuItem(uint8_t i, uint8_t k) {
+    return (const MenuItem *) pgm_read_ptr(&menus[i].item) + k;
+}
 
-/*
-=====================
- void push
-=====================
-*/
-// Decomposizione di un numero in cifre
-inline void push(long number, int8_t frame[]) {
-    for (int i = N_DIGITS - 1; i >= 0 && number > 0; i--) {
-        frame[i] = number % 10;
-        number /= 10;
+inline uint8_t itemId(const MenuItem *it) {
+    return pgm_read_byte(&it->id);
+}
+
+inline uint8_t itemKey(const MenuItem *it) {
+    return pgm_read_byte(&it->key);
+}
+
+inline const char *itemText(const MenuItem *it) {
+    return (const char *) pgm_read_ptr(&it->text);
+}
+
+inline uint8_t itemSub(const MenuItem *it) {
+    return pgm_read_byte(&it->index);
+}
+
+inline uint8_t itemAccel(const MenuItem *it) {
+    return pgm_read_byte(&it->accel);
+}
+
+// FMT_ONOFF and FMT_YESNO come from the item flags
+inline uint8_t itemFormat(const MenuItem *it) {
+    if (hasMask(it, OnOff)) return FMT_ONOFF;
+    if (hasMask(it, YesNo)) return FMT_YESNO;
+    return pgm_read_byte(&it->format);
+}
+
+inline long itemMin(const MenuItem *it) {
+    return pgm_read_dword(&it->min);
+}
+
+inline long itemMax(const MenuItem *it) {
+    return pgm_read_dword(&it->max);
+}
+
+// Only for the items with a value
+inline long &valueOf(const MenuItem *it) {
+    return values[pgm_read_byte(&it->index)];
+}
+
+// Buttons, submenus and labels have no place in values[]
+inline boolean hasValue(const MenuItem *it) {
+    return hasMask(it, Item) && !hasMask(it, Button) && !hasMask(it, Label);
+}
+
+inline void runItem(const MenuItem *it) {
+    ((void (*)(void)) pgm_read_ptr(&it->action))();
+}
+
+inline uint16_t properties(const MenuItem *it) {
+    return (pgm_read_word(&it->properties) & ~RUNTIME_FLAGS)
+           | itemFlags[itemId(it)];
+}
+
+inline void setBit(uint8_t *mask, uint8_t id, boolean on) {
+    if (on) mask[id >> 3] |= 1 << (id & 7);
+    else mask[id >> 3] &= ~(1 << (id & 7));
+}
+
+inline boolean getBit(const uint8_t *mask, uint8_t id) {
+    return mask[id >> 3] & (1 << (id & 7));
+}
+
+inline boolean isShown(uint8_t id) {
+    return getBit(shown, id);
+}
+
+// Both masks from Hide and Label
+inline void setShown(const MenuItem *it, boolean on) {
+    setBit(shown, itemId(it), on);
+    setBit(selectable, itemId(it), on && !hasMask(it, Label));
+}
+
+inline void setMask(const MenuItem *it, uint8_t attr, boolean on) {
+    if (on) itemFlags[itemId(it)] |= attr;
+    else itemFlags[itemId(it)] &= ~attr;
+
+    if (attr & Hide) setShown(it, !on);
+}
+
+// Power on values and flags
+void initItems() {
+    for (uint8_t i = 0; i < LIST(menus); i++) {
+        for (uint8_t k = 0; k < menuItems(i); k++) {
+            const MenuItem *it = menuItem(i, k);
+
+            if (hasValue(it)) valueOf(it) = pgm_read_dword(&it->def);
+            itemFlags[itemId(it)] = pgm_read_word(&it->properties) & RUNTIME_FLAGS;
+            setShown(it, !(itemFlags[itemId(it)] & Hide));
+        }
     }
 }
 
+// Every menu a run of consecutive ids, see the items identifier, and
+// every value in values[]
+boolean treeInOrder() {
+    for (uint8_t i = 0; i < LIST(menus); i++) {
+        uint8_t first = itemId(menuItem(i, 0));
 
-/*
-=====================
- long pop
-=====================
-*/
-// Composizione di cifre in un numero intero
-inline long pop(int8_t frame[]) {
-    long n = 0;
+        for (uint8_t k = 0; k < menuItems(i); k++) {
+            const MenuItem *it = menuItem(i, k);
 
-    for (int i = 0; i < N_DIGITS; i++)
-        n = n * 10 + frame[i];
-    return n;
+            if (itemId(it) != first + k) return false;
+            if (hasValue(it) && pgm_read_byte(&it->index) >= N_VALUES)
+                return false;
+        }
+    }
+    return true;
+}
+
+void (* Reset_AVR)(void) = 0;
+
+void checkMe() {
+    loopMenu = values[VAL_MENU_LOOP];
+    speakerOn = values[VAL_KEY_TONE];
 }
 
 
+// ----------------------------------------------------------------------------
+// Digit editor on the LCD
+//
+LcdTarget lcdTarget(lcd);
+NumberEditor<9, false, 0, LcdTarget> editor(lcdTarget);
+
+
 /*
 =====================
  void overwriteItem
@@ -222,7 +537,7 @@ void overwriteItem() {
     drawRect();
     display.invertText(true);
     display.print("SET YOUR DESTINY 23", MARGIN_L, MENU_H * rectY + CENTER_TEXT);
-    display.update();
+    updateScreen();
 }
 
 
@@ -232,6 +547,11 @@ void overwriteItem() {
 =====================
 */
 void menuIdle(boolean yesno) {
+    // window() clears it on every frame without a detent
+    if (yesno) stopPressEvent = true;
+    // Already idle, the LCD is set up
+    if (yesno && rotary_off) return;
+
     if (yesno) {
         overwriteItem();
         chipSelect(__LCD__I2C);
@@ -239,11 +559,11 @@ void menuIdle(boolean yesno) {
         lcd.backlight();
         lcd.blink();
     } else {
+        chipSelect(__LCD__I2C);
         lcd.clear();
         lcd.autoscroll();
         lcd.noBacklight();
         lcd.noBlink();
-        chipSelect(__SCREEN__I2C);
         closeItem();
     }
 
@@ -253,17 +573,12 @@ void menuIdle(boolean yesno) {
 
 /*
 =====================
- void underscoreCursor
+ void leaveEditor
 =====================
 */
-void underscoreCursor(boolean yesno) {
-    if (yesno) {
-        lcd.noBlink();
-        lcd.cursor();
-    } else {
-        lcd.blink();
-        lcd.noCursor();
-    }
+void leaveEditor() {
+    editor.stop();
+    menuIdle(false);
 }
 
 
@@ -272,107 +587,39 @@ void underscoreCursor(boolean yesno) {
  void _lcd 
 =====================
 */
-// Su display lcd
+// Su display lcd. One step of the editor for each frame; the value
+// changes only when it's confirmed.
 void _lcd() {
-    MenuItem *mi = itemsList[ cursor ];
-    // Mappa di elementi per lo scorrimento cursore
-    int8_t digits[11] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, OK, LEAVE };
-    // Mappa grafica per la localizzazione del cursore
-    uint8_t coord[11][2] = {
-        // Cifre
-        {0,0},{1,0},{2,0},{4,0},{5,0},{6,0},{8,0},{9,0},{10,0},
-        // Conferma
-        {0,1},
-        // Esci
-        {15,1}
-    };
-    static boolean confirm = false;
-    static boolean createLayout = true;
-    static boolean updown = false;
-    static int8_t x = 0;
+    const MenuItem *mi = itemAt(cursor);
+    int16_t delta;
   
     // Blocco encoder e button in window. Item rimane invariato.
     menuIdle(true);
-    // Spezzo il numero in cifre 
-    push( mi->val, digits );   
-    
-    // Creo layout solo una volta
-    if (createLayout) {
-        byte bell[] = { 
-            B00100, 
-            B01110, 
-            B01110, 
-            B01110,
-            B11111,
-            B00000,
-            B00100,
-            B00000
-        };
-        lcd.createChar(0, bell);
-        lcd.home();
-  
-        for ( int i = 0; i < N_DIGITS; i++ ) {
-            lcd.print( digits[i] );
-            if ( (i + 1 ) % 3 == 0 && i != N_DIGITS - 1)
-                lcd.print(" ");
-        }
+    // The screen jobs may have moved the mux
+    chipSelect(__LCD__I2C);
 
-        lcd.setCursor(0, 1);
-        lcd.write(0);
-        lcd.setCursor(15, 1);
-        lcd.print(">");
-
-        createLayout = false;
-    }
+    if (!editor.active()) editor.start(valueOf(mi));
 
     // Encoder
-    if (!confirm) {   
-        int16_t delta = encoder->getValue();
-    
-        if ( delta != 0 && !buttonReleased() ) {
-            // Per cifre 
-            if (updown) {
-                digits[x] += delta;
-                if (digits[x] < 0) digits[x] = 9;
-                else if (digits[x] > 9)
-                    digits[x] = 0;
-                lcd.print( digits[x] );
-                // Salvo valore nel item selezionato
-                mi->val = pop( digits );
-            } else {
-                // Per selezione
-                int8_t mapsize = LIST( digits );
-                x += delta;
-                if ( x < 0 )
-                    x = mapsize;
-                else if ( x > mapsize ) 
-                    x = 0;                
-            }
-        }
-
-        lcd.setCursor(   coord[x][0], coord[x][1]   );
-        underscoreCursor(updown);    
-    }
+    delta = rotaryDelta();
+    if (delta != 0 && !buttonReleased()) editor.turn(delta);
 
     // Pulsante
-    if ( buttonClicked() ) {
-        if ( digits[x] == OK ) {
-            confirm = !confirm;
-        } else if ( digits[x] == LEAVE ) {
-            createLayout = true;
-            confirm = false;
-            x = 0;
-
-            menuIdle(false);
-        } else {
-            updown = !updown;
+    if (buttonClicked()) {
+        switch (editor.click()) {
+            case EDIT_CONFIRMED:
+                // Salvo valore nel item selezionato
+                valueOf(mi) = constrain(editor.value(), itemMin(mi), itemMax(mi));
+                setMask(mi, Modified, true);
+                // Out of range: the digits go back to the limit
+                editor.show(valueOf(mi));
+                break;
+            case EDIT_LEFT:
+                leaveEditor();
+                break;
         }
     }
 
-    if (confirm) {  
-        lcd.noBlink();
-    } 
-
     // updateButton in window
 }
 
@@ -382,12 +629,16 @@ void _lcd() {
  void powerOn
 =====================
 */
+#define INTRO_NOTE 150
+
+void powerOnNote() {
+    tone(PiezoPin, 784, INTRO_NOTE);
+}
+
 void powerOn() {
-    int duration = 150;
     // Play intro
-    tone(PiezoPin, 1046, duration);
-    delay(duration + 50);
-    tone(PiezoPin, 784, duration);
+    tone(PiezoPin, 1046, INTRO_NOTE);
+    scheduler.after(powerOnNote, INTRO_NOTE + 50);
 }
 
 
@@ -404,10 +655,7 @@ void menuTone() {
                 10); 
     }
 
-    direction = 0;
-    offset = BUFSIZE;
-    head = 0;
-    tail = 0;
+    marquee.reset();
 }
 
 
@@ -416,12 +664,9 @@ void menuTone() {
  void chipSelect
 =====================
 */
+// Nothing is sent if the channel is already selected
 void chipSelect(byte bus) {
-    if (bus > 7) return;
-    Wire.beginTransmission(0x70);
-    Wire.write(1 << bus);
-    Wire.endTransmission();
-    delay(10);
+    i2c.select(bus);
 }
 
 
@@ -430,25 +675,258 @@ void chipSelect(byte bus) {
  void storeData
 =====================
 */
-void storeData() {
-    int addr = 0;
+// Eeprom journal. Every save appends a record for each changed item,
+// boot replays the newest valid record of each key.
+//
+//   record   [ key | seq lo | seq hi | val (4) | crc ]
+//
+//   bank 0   [ snapshot ... | r | r | r |             ]
+//   bank 1   [                                       ]
+//                                         ^ head
+//
+// When a bank is full the next save starts the other bank with a
+// snapshot of all the values, so the old bank can be overwritten.
+// A torn record fails the CRC and the older copy is used.
+#define EEPROM_ADDR    0x50
+#define EEPROM_PAGE    32
+#define EEPROM_CHUNK   24  // Records for each write, inside the Wire buffer
+#define JOURNAL_START  256 // Above the old fixed layout
+#define RECORD_SIZE    8
+#define BANK_SLOTS     64
+#define JOURNAL_SLOTS  (2 * BANK_SLOTS)
+#define MAX_KEYS       16
+
+#if BENCHMARK
+// benchSave() moves it to a scratch journal above the real one
+int journalStart = JOURNAL_START;
+#else
+#define journalStart JOURNAL_START
+#endif
+
+uint8_t journalHead = 0;
+uint16_t journalSeq = 0;
+boolean snapshot = false;
+
+// Save in progress. A save asked for meanwhile starts over
+// when this one is done.
+uint8_t saveMenu = 0, saveItem = 0;
+uint8_t saveTotal = 0, saveDone = 0;
+boolean saveAgain = false;
+void (*saveCallback)(void) = NULL;
+// Statistics
+unsigned long saveStart = 0;
+uint16_t saveBytes = 0;
+
+// Acknowledge polling: the eeprom ignores its address
+// until the write cycle is over.
+boolean eeReady() {
+    Wire.beginTransmission(EEPROM_ADDR);
+    return Wire.endTransmission() == 0;
+}
 
-    chipSelect(__EEPROM__I2C);
+void eePageWrite(int addr, const byte *data, uint8_t len) {
+    Wire.beginTransmission(EEPROM_ADDR);
+    Wire.write(addr >> 8);
+    Wire.write(addr & 0xff);
+    Wire.write(data, len);
+    Wire.endTransmission();
+}
 
-    for (int i = 0; i < LIST(menus); i++) {
-        for (int k = 0; k < menus[i].items; k++) {
-            // Mi interressa solo il valore di val. Min/Max sono
-            // constanti.
-            addr += eeWrite(addr, menus[i].item[k].val);
-            // Importante!!!
-            delay(7);
+void eeReadBlock(int addr, byte *data, uint8_t len) {
+    Wire.beginTransmission(EEPROM_ADDR);
+    Wire.write(addr >> 8);
+    Wire.write(addr & 0xff);
+    Wire.endTransmission();
+
+    Wire.requestFrom((uint8_t) EEPROM_ADDR, len);
+    for (uint8_t i = 0; i < len; i++)
+        data[i] = Wire.available() ? Wire.read() : 0xff;
+}
+
+// CRC-8, polynomial 0x07
+uint8_t crc8(const byte *data, uint8_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+void makeRecord(byte *rec, const MenuItem *it) {
+    rec[0] = itemKey(it);
+    rec[1] = journalSeq & 0xff;
+    rec[2] = journalSeq >> 8;
+    int32_t val = valueOf(it);
+
+    memcpy(rec + 3, &val, sizeof(val));
+    rec[RECORD_SIZE - 1] = crc8(rec, RECORD_SIZE - 1);
+}
+
+boolean validRecord(const byte *rec) {
+    return rec[0] != 0 && rec[0] < MAX_KEYS
+                       && crc8(rec, RECORD_SIZE - 1) == rec[RECORD_SIZE - 1];
+}
+
+const MenuItem *findKey(uint8_t key) {
+    for (uint8_t i = 0; i < LIST(menus); i++)
+        for (uint8_t k = 0; k < menuItems(i); k++)
+            if (itemKey(menuItem(i, k)) == key) return menuItem(i, k);
+    return NULL;
+}
+
+// Next item to append, NULL at the end
+const MenuItem *nextDirty() {
+    while (saveMenu < LIST(menus)) {
+        if (saveItem >= menuItems(saveMenu)) {
+            saveMenu++;
+            saveItem = 0;
+            continue;
         }
+
+        const MenuItem *it = menuItem(saveMenu, saveItem);
+        if (itemKey(it) != 0 && hasMask(it, Modified)) return it;
+        saveItem++;
     }
+    return NULL;
+}
 
-    chipSelect(__SCREEN__I2C);
+// Every saved item
+void markAll() {
+    for (uint8_t i = 0; i < LIST(menus); i++)
+        for (uint8_t k = 0; k < menuItems(i); k++)
+            if (itemKey(menuItem(i, k)) != 0)
+                setMask(menuItem(i, k), Modified, true);
+}
+
+uint8_t countDirty() {
+    uint8_t n = 0;
 
-   lampOfGod();
-  //Reset_AVR();
+    for (uint8_t i = 0; i < LIST(menus); i++)
+        for (uint8_t k = 0; k < menuItems(i); k++)
+            if (itemKey(menuItem(i, k)) != 0
+                    && hasMask(menuItem(i, k), Modified))
+                n++;
+    return n;
+}
+
+// Progress bar on the last row of the screen. It is one page, so the
+// update costs a few bytes. Over the selection bar of the last row it
+// is inverted: cleared, it gives the bar its bottom line back.
+void drawProgress() {
+    int w = saveTotal ? SCR_WIDTH * saveDone / saveTotal : 0;
+    int8_t bar = drawnBar != NO_BAR ? drawnBar
+                                    : startY + MENU_H * (drawnCursor - drawnTop);
+
+    display.fillRect(0, SCR_HEIGHT - 1, w, 1);
+    display.fillRect(w, SCR_HEIGHT - 1, SCR_WIDTH - w, 1, FILL_CLEAR);
+    if (redraw && depth > 0 && (drawnTop >= 0 || drawnBar != NO_BAR)
+            && bar > SCR_HEIGHT - 1 - MENU_H && bar < SCR_HEIGHT)
+        display.fillRect(0, SCR_HEIGHT - 1, SCR_WIDTH, 1, FILL_INVERT);
+    updateScreen();
+}
+
+// Runs on the eeprom channel
+void commitSlice() {
+    byte buf[EEPROM_CHUNK];
+    uint8_t len = 0;
+    int addr;
+    const MenuItem *it;
+
+    // Still busy with the last write
+    if (!eeReady()) return;
+
+    it = nextDirty();
+
+    // Changed while saving
+    if (it == NULL && saveAgain) {
+        saveAgain = false;
+        saveMenu = 0;
+        saveItem = 0;
+        saveTotal = saveDone + countDirty();
+        it = nextDirty();
+    }
+
+    if (it == NULL) {
+        snapshot = false;
+        scheduler.stop(commitData);
+#if DEBUG_STATS
+        printStat("Save bytes", saveBytes);
+        printStat("Save ms", millis() - saveStart);
+#endif
+        saveTotal = 0;
+        drawProgress();
+        if (saveCallback) saveCallback();
+        //Reset_AVR();
+        return;
+    }
+
+    // New bank: begin with all the values
+    if (journalHead % BANK_SLOTS == 0 && !snapshot) {
+        snapshot = true;
+        markAll();
+        saveMenu = 0;
+        saveItem = 0;
+        saveTotal = saveDone + countDirty();
+        it = nextDirty();
+    }
+
+    addr = journalStart + journalHead * RECORD_SIZE;
+    do {
+        makeRecord(buf + len, it);
+        len += RECORD_SIZE;
+        setMask(it, Modified, false);
+
+        journalHead = (journalHead + 1) % JOURNAL_SLOTS;
+        journalSeq++;
+
+        saveItem++;
+        saveDone++;
+        it = nextDirty();
+    } while (it && len + RECORD_SIZE <= EEPROM_CHUNK
+                && (addr + len) % EEPROM_PAGE != 0
+                && journalHead % BANK_SLOTS != 0);
+
+    eePageWrite(addr, buf, len);
+    saveBytes += len;
+
+    drawProgress();
+}
+
+void commitData() {
+    i2c.post(__EEPROM__I2C, commitSlice);
+}
+
+/*
+=====================
+ void saveData
+=====================
+*/
+// Start a save in background, done() runs when it's over. The slices
+// run from the scheduler, one page write each, and never wait for the
+// eeprom: a busy eeprom just skips the slice.
+void saveData(void (*done)(void)) {
+    saveCallback = done;
+
+    if (scheduler.pending(commitData)) {
+        saveAgain = true;
+        return;
+    }
+
+    saveMenu = 0;
+    saveItem = 0;
+    saveDone = 0;
+    saveTotal = countDirty();
+    saveBytes = 0;
+    saveStart = millis();
+
+    scheduler.every(commitData, 1);
+}
+
+void storeData() {
+    saveData(lampOfGod);
 }
 
 
@@ -458,13 +936,52 @@ void storeData() {
 =====================
 */
 void loadData() {
-    int addr = 0;
+    byte rec[RECORD_SIZE];
+    uint16_t newest[MAX_KEYS];
+    uint8_t where[MAX_KEYS];
+    uint16_t found = 0;
+    uint8_t top = 0;
 
     chipSelect(__EEPROM__I2C);
 
-    for (int i = 0; i < LIST(menus); i++) {
-        for (int k = 0; k < menus[i].items; k++)
-            addr += eeRead(addr, menus[i].item[k].val);
+    for (uint8_t slot = 0; slot < JOURNAL_SLOTS; slot++) {
+        eeReadBlock(journalStart + slot * RECORD_SIZE, rec, RECORD_SIZE);
+        if (!validRecord(rec)) continue;
+
+        uint8_t key = rec[0];
+        uint16_t seq = rec[1] | rec[2] << 8;
+
+        // Newest record of the journal
+        if (found == 0 || (int16_t) (seq - journalSeq) >= 0) {
+            journalSeq = seq + 1;
+            top = slot;
+        }
+
+        // Newest record of the key
+        if ((found & (1 << key)) && (int16_t) (seq - newest[key]) < 0)
+            continue;
+
+        found |= 1 << key;
+        newest[key] = seq;
+        where[key] = slot;
+
+        const MenuItem *it = findKey(key);
+        if (it) {
+            int32_t val;
+            memcpy(&val, rec + 3, sizeof(val));
+            valueOf(it) = constrain(val, itemMin(it), itemMax(it));
+        }
+    }
+
+    if (found) journalHead = (top + 1) % JOURNAL_SLOTS;
+
+    // A snapshot cut short: values left in the other bank
+    // are appended again with the next save.
+    for (uint8_t key = 1; key < MAX_KEYS; key++) {
+        const MenuItem *it = findKey(key);
+        if (it && (found & (1 << key))
+               && where[key] / BANK_SLOTS != top / BANK_SLOTS)
+            setMask(it, Modified, true);
     }
 
     chipSelect(__SCREEN__I2C);
@@ -476,15 +993,129 @@ void loadData() {
  void lampOfGod
 =====================
 */
+void lampOff() {
+    chipSelect(__SCREEN__I2C);
+    display.invert(false);
+    invalidate(DIRTY_ALL);
+}
+
 void lampOfGod() {
 
     display.clrScr();
+    chipSelect(__SCREEN__I2C);
     display.invert(true);
-    display.update();
-    delay(100);
+    updateScreen();
 
-    display.invert(false);
+    scheduler.after(lampOff, 100);
+}
+
+
+/*
+=====================
+ void printStat
+=====================
+*/
+#if DEBUG_STATS || BENCHMARK
+void printStat(const char *name, unsigned long value) {
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.println(value);
+}
+#endif
+
+
+#if DEBUG_STATS
+void reportTasks() {
+    scheduler.report(Serial);
+    printStat("Dropped events", events.dropped);
+    printStat("Encoder edges", encoder.edges);
+    printStat("Encoder invalid", encoder.invalid);
+    printStat("Frames", frames);
+    printStat("Passes", passes);
+    printStat("Glyphs", display.glyphs);
+    printStat("Glyphs/frame", frames ? display.glyphs / frames : 0);
+    printStat("Label cache hits", labels.hits);
+    printStat("Label cache misses", labels.misses);
+    printStat("Value cache hits", previews.hits);
+    printStat("Value cache misses", previews.misses);
+    printStat("OLED transactions", display.transactions);
+    printStat("LCD I2C bytes", lcdTarget.bytes);
+    printStat("Mux switches", i2c.switches);
+    printStat("Mux switches avoided", i2c.avoided);
 }
+#endif
+
+
+#if REPLAY
+/*
+=====================
+ void replayInput
+=====================
+*/
+// Scripted input, ms from the start. Every new frame is sent on
+// Serial as a PBM image.
+typedef struct {
+    uint16_t at;
+    uint8_t type;
+    int8_t value;
+} ScriptStep;
+
+const ScriptStep inputScript[] PROGMEM = {
+    {  500, EV_DETENT,  1 },    // DISPLAY
+    { 1000, EV_CLICK,   0 },    // Open
+    { 1500, EV_DETENT,  1 },    // KEY TONE
+    { 2000, EV_DETENT, -1 },    // MENU LOOP
+    { 2500, EV_DETENT,  2 },    // <-
+    { 3000, EV_CLICK,   0 },    // Back
+};
+
+uint8_t scriptStep = 0;
+unsigned long scriptStart = 0, scriptFrames = 0;
+
+void replayInput() {
+    ScriptStep st;
+
+    while (scriptStep < LIST(inputScript)) {
+        memcpy_P(&st, &inputScript[scriptStep], sizeof(st));
+        if (millis() - scriptStart < st.at) break;
+
+        events.push(st.type, st.value, micros());
+        scriptStep++;
+    }
+
+    if (frames != scriptFrames) {
+        scriptFrames = frames;
+        display.dump(Serial);
+    }
+}
+#endif
+
+
+#if DEBUG_STATS
+/*
+=====================
+ void benchFill
+=====================
+*/
+// Selection bar: old line loop against fillRect()
+void benchFill() {
+    unsigned long t;
+    const int runs = 100;
+
+    t = micros();
+    for (int n = 0; n < runs; n++)
+        for (int i = 0; i < SCR_WIDTH; i++)
+            display.drawLine(i, 0, i, MENU_H);
+    printStat("drawLine cycles/fill", (micros() - t) * (F_CPU / 1000000L) / runs);
+
+    t = micros();
+    for (int n = 0; n < runs; n++)
+        display.fillRect(0, 0, SCR_WIDTH, MENU_H);
+    printStat("fillRect cycles/fill", (micros() - t) * (F_CPU / 1000000L) / runs);
+
+    display.clrScr();
+}
+#endif
 
 
 /*
@@ -492,88 +1123,508 @@ void lampOfGod() {
  void timerIsr
 =====================
 */
+// Button events, 1 kHz while the button is in use
 void timerIsr() {
-        encoder->service();
+#if REPLAY
+        // replayInput() is the producer
+        return;
+#endif
+        pushButton.sample((PINB & (1 << PINB0)) == 0, micros(), events);
+
+        if (pushButton.idle()) {
+            Timer1.stop();
+            sampling = false;
+        }
+}
+
+
+// An edge of the button starts the sampling again
+ISR(PCINT0_vect) {
+    if (!sampling) {
+        sampling = true;
+        Timer1.start();
+    }
 }
 
 
+/*
+=====================
+ void encoderIsr
+=====================
+*/
+// Detent events, on every edge of A or B
+void encoderIsr() {
+#if REPLAY
+        return;
+#endif
+        uint8_t pins = PIND;
+
+        // A << 1 | B
+        encoder.update((pins >> (PIND2 - 1) & 2) | (pins >> PIND3 & 1), micros(), events);
+}
+
+
+#if BENCHMARK
+// Benchmarks run, and those that sent nothing to the OLED or the LCD:
+// they measured nothing
+uint8_t benchesRun = 0, benchesSilent = 0;
+
+/*
+=====================
+ void benchmark
+=====================
+*/
+// Average cost of one run of step(). The time includes the blocking
+// I2C transfers; for the steps driven by an input event it is also the
+// input to pixel latency, plus up to FRAME_PERIOD waiting for window().
+void benchmark(const char *name, void (*reset)(void), void (*step)(void),
+               uint8_t runs) {
+    unsigned long us = 0, bytes = 0, glyphs = 0, lcdSent = 0, lcdWrites = 0;
+    uint16_t updates = 0;
+
+    for (uint8_t n = 0; n < runs; n++) {
+        if (reset) reset();
+
+        unsigned long b = display.bytesSent;
+        uint16_t u = display.updates;
+        unsigned long g = display.glyphs;
+        unsigned long l = lcdTarget.bytes;
+        unsigned long w = lcdTarget.writes;
+        unsigned long t = micros();
+
+        step();
+        i2c.run();
+
+        us += micros() - t;
+        bytes += display.bytesSent - b;
+        updates += display.updates - u;
+        glyphs += display.glyphs - g;
+        lcdSent += lcdTarget.bytes - l;
+        lcdWrites += lcdTarget.writes - w;
+    }
+
+    Serial.println(name);
+    printStat("  us", us / runs);
+    printStat("  I2C bytes", bytes / runs);
+    printStat("  updates", updates / runs);
+    printStat("  glyphs", glyphs / runs);
+    printStat("  LCD I2C bytes", lcdSent / runs);
+    printStat("  LCD writes", lcdWrites / runs);
+
+    benchesRun++;
+    if (updates + lcdWrites == 0 || bytes + lcdSent == 0) benchesSilent++;
+}
+
+// Main menu, already on screen
+void benchRoot() {
+    depth = 0;
+    openLevel(MAIN_MENU);
+    buttonPressed_i = 0;
+    rotary_accel = rotary_off = false;
+    redraw = true;
+    invalidate(DIRTY_ALL);
+    window();
+    i2c.run();
+}
+
+// The click opens the menu, the next pass draws it
+void benchOpen() {
+    events.push(EV_CLICK, 0, micros());
+    window();
+    window();
+}
+
+// SETTINGS open, on CLOCK 0, already on screen
+void benchSettings() {
+    benchRoot();
+    benchOpen();
+    i2c.run();
+}
+
+void benchScroll() {
+    events.push(EV_DETENT, 1, micros());
+    window();
+}
+
+// Encoder at full acceleration, 10 steps in one frame
+void benchCount() {
+    rotary_accel = true;
+    stepValue(10);
+    option();
+}
+
+// 1000 detents in one burst, 8 events of 125. The timestamps are far
+// apart for steps of one: every detent counts and the value is drawn
+// once.
+void benchSpin() {
+    unsigned long f = frames, t = micros();
+
+    rotary_accel = true;
+    values[VAL_CLOCK_0] = 8000;
+    for (uint8_t n = 0; n < 8; n++)
+        events.push(EV_DETENT, 125, t + n * 2000UL * ACCEL_SLOW);
+
+    updateButton();
+    stepValue(rotaryDelta());
+    option();
+    i2c.run();
+
+    Serial.println("Spin 1000 detents");
+    printStat("  value (9000)", values[VAL_CLOCK_0]);
+    printStat("  frames (1)", frames - f);
+}
+
+// The time includes the eeprom write cycles. The records go to a
+// scratch journal: the saved values and the head are left as they are.
+#define BENCH_JOURNAL (JOURNAL_START + JOURNAL_SLOTS * RECORD_SIZE)
+
+void benchSave() {
+    uint8_t head = journalHead;
+    uint16_t seq = journalSeq;
+
+    itemFlags[CLOCK_0] |= Modified;
+    journalStart = BENCH_JOURNAL;
+    journalHead = 0;
+
+    storeData();
+    while (scheduler.pending(commitData)) {
+        commitData();
+        i2c.run();
+        delay(1);
+    }
+
+    journalStart = JOURNAL_START;
+    journalHead = head;
+    journalSeq = seq;
+}
+
+// AB of the encoder one step after the other in the +1 direction
+const uint8_t quadratureTrace[4] = { 0, 1, 3, 2 };
+
+// Turn q by the given detents, every edge bounces once. The queue is
+// read every 20 detents, a frame at 500 detents/s: most of the time
+// it is full. Returns the detents that came out of the queue.
+long decodeTrace(QuadratureDecoder &q, EventQueue &queue, int16_t detents,
+                 uint8_t &pos, uint16_t &edges) {
+    InputEvent ev;
+    long sum = 0;
+    int8_t dir = detents < 0 ? -1 : 1;
+
+    for (uint16_t s = 0; s < abs(detents) * StepsPerNotch; s++) {
+        uint8_t from = quadratureTrace[pos & 3];
+        uint8_t to = quadratureTrace[(pos += dir) & 3];
+
+        q.update(to, s, queue);
+        q.update(from, s, queue);
+        q.update(to, s, queue);
+        edges += 3;
+
+        if (s % (20 * StepsPerNotch) == 0)
+            while (queue.pop(ev)) sum += ev.value;
+    }
+    while (queue.pop(ev)) sum += ev.value;
+    sum += q.take();
+
+    return sum;
+}
+
+// The decoder on fast, bouncing traces, and its cost for each edge
+void benchDecoder() {
+    QuadratureDecoder q(StepsPerNotch);
+    EventQueue queue;
+    uint8_t pos = 0;
+    uint16_t edges = 0;
+    unsigned long t = micros();
+
+    q.begin(quadratureTrace[0]);
+    long up = decodeTrace(q, queue, 1000, pos, edges);
+    long down = decodeTrace(q, queue, -1000, pos, edges);
+    t = micros() - t;
+
+    Serial.println("Quadrature decoder");
+    printStat("  up (1000)", up);
+    printStat("  down (1000)", -down);
+    printStat("  invalid (0)", q.invalid);
+    printStat("  cycles/edge", t * (F_CPU / 1000000L) / edges);
+}
+
+void benchDigit() {
+    events.push(EV_DETENT, 1, micros());
+    updateButton();
+    _lcd();
+}
+
+void runBenchmarks() {
+    long loop = values[VAL_MENU_LOOP];
+    long clock = values[VAL_CLOCK_0];
+    uint8_t flags[N_ITEMS];
+
+    memcpy(flags, itemFlags, sizeof(flags));
+
+    values[VAL_MENU_LOOP] = 1;
+
+    // On the host the CPU takes no time: only the bus moves micros()
+    Serial.println("Benchmarks, us = CPU + I2C (host: I2C only, "
+                   "cycles/edge 0)");
+    benchRoot();
+    benchmark("Scroll main menu", NULL, benchScroll, 20);
+    benchmark("Open menu", benchRoot, benchOpen, 10);
+    benchSettings();
+    benchmark("Scroll items", NULL, benchScroll, 20);
+    benchmark("Count up x10", benchSettings, benchCount, 10);
+    benchSettings();
+    benchSpin();
+    benchDecoder();
+    benchmark("Save", NULL, benchSave, 1);
+    benchSettings();
+    // From the first digit to the last one, then turn it
+    benchmark("Digit cursor", NULL, benchDigit, 8);
+    events.push(EV_CLICK, 0, micros());
+    updateButton();
+    _lcd();
+    benchmark("Digit change", NULL, benchDigit, 20);
+    leaveEditor();
+
+    values[VAL_MENU_LOOP] = loop;
+    values[VAL_CLOCK_0] = clock;
+    memcpy(itemFlags, flags, sizeof(flags));
+    printStat("Silent benchmarks (0)", benchesSilent);
+    benchRoot();
+}
+#endif
+
+
 /*
 =====================
  void setup
 =====================
 */
 void setup() {
+#if DEBUG_STATS || BENCHMARK
+    // Only these print: HardwareSerial and its buffers stay out
     Serial.begin(9600);
+#endif
+
+    initItems();
+    openLevel(MAIN_MENU);
 
     pinMode(PiezoPin, OUTPUT);
     pinMode(PushButtonPin, INPUT);
-
-    encoder = new ClickEncoder(2, 3, -1, StepsPerNotch);
-    encoder->setAccelerationEnabled(false);
+    pinMode(EncoderPinA, INPUT_PULLUP);
+    pinMode(EncoderPinB, INPUT_PULLUP);
 
 
     Wire.begin();
     Wire.setClock(400000);
 
-//    #if defined(FirstRun)
-//        storeData();
-//    #else     
-//        loadData();
-//    #endif
+    // An erased eeprom has no valid record: the power on values stay
+    // and the first save starts the journal
+    loadData();
+
+    chipSelect(__LCD__I2C);
+    lcd.init();
+    lcd.noBacklight();
+    
+    chipSelect(__SCREEN__I2C);
+    display.begin(SSD1306_128X64);
+    display.setFont(SmallFont);
+    display.setBrightness(20);
+
+#if DEBUG_STATS
+    if (!treeInOrder()) Serial.println("Menu ids out of order");
+    benchFill();
+#endif
+#if BENCHMARK
+    // Before the timer: the benchmarks produce their own events
+    runBenchmarks();
+#endif
+
+    Timer1.initialize(1000);
+    Timer1.attachInterrupt(timerIsr);
+    // Button pin change, PB0
+    PCMSK0 |= 1 << PCINT0;
+    PCICR |= 1 << PCIE0;
+
+    encoder.begin(digitalRead(EncoderPinA) << 1 | digitalRead(EncoderPinB));
+    attachInterrupt(digitalPinToInterrupt(EncoderPinA), encoderIsr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncoderPinB), encoderIsr, CHANGE);
+
+    scheduler.every(window, FRAME_PERIOD);
+    scheduler.every(scrollText, SCROLL_DELAY);
+#if DEBUG_STATS
+    scheduler.every(reportTasks, 5000);
+#endif
+#if REPLAY
+    scriptStart = millis();
+    scheduler.every(replayInput, 1);
+#endif
+
+    //powerOn();
+}
+
+
+/*
+=====================
+ boolean hasMask
+=====================
+*/
+boolean hasMask(const MenuItem *it, ItemAttributes attr) {
+    return (properties(it) & attr) != 0;
+}
+
+
+/*
+=====================
+ boolean isItem
+=====================
+*/
+boolean isItem(const MenuItem *it) {
+    return hasMask(it, Item);
+}
+
+
+/*
+=====================
+ boolean isLocked
+=====================
+*/
+boolean isLocked(const MenuItem *it) {
+    return hasMask(it, Protected);
+}
+
+
+/*
+=====================
+ boolean isLabel
+=====================
+*/
+boolean isLabel(int8_t curPos) {
+    return hasMask(itemAt(curPos), Label);
+}
 
-    chipSelect(__LCD__I2C);
-    lcd.init();
-    lcd.noBacklight();
-    
-    chipSelect(__SCREEN__I2C);
-    display.begin(SSD1306_128X64);
-    display.setFont(SmallFont);
-    display.setBrightness(20);
 
-    Timer1.initialize(1000);
-    Timer1.attachInterrupt(timerIsr);
+/*
+=====================
+ const MenuItem *itemAt
+=====================
+*/
+// Item at a position of the menu on screen, hidden items don't count.
+// Eight items at a time are skipped with the bitmask.
+const MenuItem *itemAt(int8_t pos) {
+    uint8_t first = itemId(menuItem(indexMenu, 0));
+    uint8_t n = menuItems(indexMenu);
+    uint8_t k = 0;
+
+    while (k < n) {
+        uint8_t id = first + k;
+
+        // A whole byte of the mask
+        if ((id & 7) == 0 && k + 8 <= n) {
+            uint8_t c = __builtin_popcount(shown[id >> 3]);
+
+            if (pos >= c) {
+                pos -= c;
+                k += 8;
+                continue;
+            }
+        }
 
-    //powerOn();
+        if (isShown(id) && pos-- == 0) return menuItem(indexMenu, k);
+        k++;
+    }
+    return menuItem(indexMenu, 0);
 }
 
 
 /*
 =====================
- boolean hasMask
+ uint8_t countIds
 =====================
 */
-boolean hasMask(MenuItem *it, ItemAttributes attr) {
-    return (it->properties & attr) != 0;
+// Ids in [from, to) with their bit set, a byte at a time where the
+// range covers it
+uint8_t countIds(const uint8_t *mask, uint16_t from, uint16_t to) {
+    uint8_t c = 0;
+
+    while (from < to) {
+        if ((from & 7) == 0 && from + 8 <= to) {
+            c += __builtin_popcount(mask[from >> 3]);
+            from += 8;
+        } else {
+            c += getBit(mask, from++);
+        }
+    }
+    return c;
 }
 
 
 /*
 =====================
- boolean isItem
+ int16_t findId
 =====================
 */
-boolean isItem(MenuItem *it) {
-    return (it->properties & Item) == Item;
+// First id in [from, to) with its bit set: the lowest going up, the
+// highest going down. Empty bytes are skipped whole. -1 = none
+int16_t findId(const uint8_t *mask, uint16_t from, uint16_t to, int8_t dir) {
+    if (dir > 0) {
+        while (from < to) {
+            if ((from & 7) == 0 && from + 8 <= to && mask[from >> 3] == 0) from += 8;
+            else if (getBit(mask, from)) return from;
+            else from++;
+        }
+    } else {
+        while (to > from) {
+            if ((to & 7) == 0 && to >= from + 8 && mask[(to >> 3) - 1] == 0) to -= 8;
+            else if (getBit(mask, to - 1)) return to - 1;
+            else to--;
+        }
+    }
+    return -1;
 }
 
 
 /*
 =====================
- boolean isLocked
+ int8_t stepRow
 =====================
 */
-boolean isLocked(MenuItem *it) {
-    return hasMask(it, Protected);
+// The selectable row after a row (dir 1) or before it (dir -1), -1 =
+// none. The rows in between are the shown ids on the way.
+//
+//   id      4    5    6    7    8
+//           A    LBL  LBL  LBL  B      row 0 -> 4: 4 shown in [4, 8)
+int8_t stepRow(int8_t row, int8_t dir) {
+    uint8_t first = itemId(menuItem(indexMenu, 0));
+    uint16_t end = first + menuItems(indexMenu);
+    uint8_t id = itemId(itemAt(row));
+    int16_t to;
+
+    if (dir > 0) {
+        to = findId(selectable, id + 1, end, 1);
+        return to < 0 ? -1 : row + countIds(shown, id, to);
+    }
+    to = findId(selectable, first, id, -1);
+    return to < 0 ? -1 : row - countIds(shown, to, id);
 }
 
 
 /*
 =====================
- boolean isLabel
+ void buildRows
 =====================
 */
-boolean isLabel(int8_t curPos) {
-    return (itemsList[curPos]->properties & Label) == Label;
+// Visible rows and the first and last selectable one
+void buildRows() {
+    uint8_t first = itemId(menuItem(indexMenu, 0));
+    uint16_t end = first + menuItems(indexMenu);
+    int16_t id;
+
+    arrayLen = countIds(shown, first, end);
+
+    id = findId(selectable, first, end, 1);
+    firstRow = id < 0 ? -1 : countIds(shown, first, id);
+    id = findId(selectable, first, end, -1);
+    lastRow = id < 0 ? -1 : countIds(shown, first, id);
 }
 
 
@@ -582,8 +1633,8 @@ boolean isLabel(int8_t curPos) {
  boolean isButton
 =====================
 */
-boolean isButton(MenuItem *it) {
-    return (it->properties & Button) == Button;
+boolean isButton(const MenuItem *it) {
+    return hasMask(it, Button);
 }
 
 
@@ -592,8 +1643,8 @@ boolean isButton(MenuItem *it) {
  void unlockItem
 =====================
 */
-void unlockItem(MenuItem *it) {
-    it->properties &= ~Protected;
+void unlockItem(const MenuItem *it) {
+    setMask(it, Protected, false);
 }
 
 
@@ -602,9 +1653,26 @@ void unlockItem(MenuItem *it) {
  void showItem
 =====================
 */
-void showItem(MenuItem *it, boolean visible) {
-    if (visible) it->properties &= ~Hide;
-    else it->properties |= Hide;
+// The rows below the item move: the cursor stays on its item, or goes
+// to the nearest row it can stop on when its item is hidden
+void showItem(const MenuItem *it, boolean visible) {
+    uint8_t first = itemId(menuItem(indexMenu, 0));
+    uint16_t end = first + menuItems(indexMenu);
+    uint8_t id = arrayLen > 0 ? itemId(itemAt(cursor)) : first;
+    int16_t down, up;
+
+    setMask(it, Hide, !visible);
+    buildRows();
+
+    down = findId(selectable, id, end, 1);
+    up = findId(selectable, first, id, -1);
+    if (down != id && up >= 0
+        && (down < 0 || countIds(shown, up, id) < countIds(shown, id, down)))
+        down = up;
+
+    listSlide = barSlide = 0;
+    moveCursor(down < 0 ? 0 : countIds(shown, first, down));
+    invalidate(DIRTY_LIST);
 }
 
 
@@ -614,7 +1682,7 @@ void showItem(MenuItem *it, boolean visible) {
 =====================
 */
 void drawBox(int x, int y, int w, int h) {
-    for (int i = 0; i < w; i++) display.drawRect(x, y, x + i, y + h);
+    display.fillRect(x, y, w, h + 1);
 }
 
 
@@ -628,8 +1696,26 @@ void drawScrollbar() {
     for (int i = 0; i < SCR_HEIGHT - 2; i += 2) {
         display.setPixel(SCR_WIDTH - 3, i);
     }
-    // Draw the handle.
-    drawBox(124, 62 / arrayLen * cursor, 3, 62 / arrayLen);
+    // Draw the handle. Long lists get a short handle, not a zero one.
+    int h = max(2, 62 / arrayLen);
+    drawBox(124, (62 - h) * cursor / max(1, arrayLen - 1), 3, h);
+}
+
+
+/*
+=====================
+ void moveCursor
+=====================
+*/
+// The selection stays on the last row of the screen while the list
+// scrolls under it:
+//
+//   rectY  = min(cursor, screenEnd - 1)
+//   scroll = cursor - rectY
+void moveCursor(int8_t to) {
+    cursor = to;
+    rectY  = min(cursor, screenEnd - 1);
+    scroll = cursor - rectY;
 }
 
 
@@ -639,40 +1725,20 @@ void drawScrollbar() {
 =====================
 */
 void cursorDown() {
-    // Stop cursor
-    if (arrayLen == 1 || (cursor + 1 == arrayLen - 1 && isLabel(arrayLen - 1)) 
-                      && !loopMenu) 
-        return;
-        
-    // Cursor at end    
-    if (cursor == arrayLen - 1) {
-        if (loopMenu)
-        { 
-            cursor = isLabel(0);
-            rectY  = isLabel(0);
-            scroll = 0;
+    int8_t to;
 
-            goto end;
-        } 
+    // Every row hidden
+    if (arrayLen == 0) return;
 
-        return;
-    }
+    to = stepRow(cursor, 1);
 
-    cursor++;
-       
-    // Begin scrolling
-    if (cursor >= screenEnd) {
-        rectY = screenEnd - 1;
-        scroll++;
-    } else {
-        rectY++;
+    // Cursor at end
+    if (to < 0) {
+        if (!loopMenu || firstRow < 0 || firstRow == cursor) return;
+        to = firstRow;
     }
 
-
- // Skip labels
- end:
-    if (isLabel(cursor)) cursorDown();
-
+    moveCursor(to);
     menuTone();
 }
 
@@ -683,47 +1749,20 @@ void cursorDown() {
 =====================
 */
 void cursorUp()  {
-    // Stop cursor
-    if (arrayLen == 1 || cursor - 1 == 0 && isLabel(0)) { 
-        if (loopMenu) 
-            cursor = 0; 
-        else 
-            return; 
-    }
-
-    // Cursor at begin
-    if (cursor == 0) {
-        if (loopMenu) {
-            cursor = arrayLen - 1;
-
-            if (arrayLen < screenEnd) {
-                rectY = cursor;
-                scroll = 0;
-            } else {
-                rectY = screenEnd - 1;
-                scroll = arrayLen - screenEnd;
-            }
+    int8_t to;
 
-            goto end;
-        }
+    // Every row hidden
+    if (arrayLen == 0) return;
 
-        return;
-    }
+    to = stepRow(cursor, -1);
 
-    // Scrolling
-    if (cursor >= screenEnd) {
-        rectY = screenEnd - 1;
-        scroll--;
-    } else {
-        rectY--;
+    // Cursor at begin
+    if (to < 0) {
+        if (!loopMenu || lastRow < 0 || lastRow == cursor) return;
+        to = lastRow;
     }
 
-    cursor--;
-
- //Skip labels
- end:
-    if(isLabel(cursor)) cursorUp();
-    
+    moveCursor(to);
     menuTone();
 }
 
@@ -751,12 +1790,50 @@ void playLoad() {
 */
 void exitMain() {
 
-    cursor          =  0;
-    rectY           =  0;
-    scroll          =  0;
-    indexMenu       =  0;
+    depth = 0;
+    openLevel(MAIN_MENU);
     buttonPressed_i = -1;
     rotary_off = true;
+    invalidate(DIRTY_ALL);
+}
+
+
+/*
+=====================
+ void openLevel
+=====================
+*/
+// Show menus[m] from the top
+void openLevel(uint8_t m) {
+    indexMenu = m;
+    buildRows();
+    listSlide = barSlide = 0;
+
+    moveCursor(max(firstRow, 0));
+
+    redraw = true;
+    invalidate(DIRTY_LIST);
+}
+
+
+/*
+=====================
+ void enterMenu
+=====================
+*/
+void enterMenu(uint8_t m) {
+    // Too deep, stay here
+    if (depth == MAX_DEPTH) return;
+
+    // Salva cursori
+    levels[depth].menu   = indexMenu;
+    levels[depth].cursor = cursor;
+    levels[depth].rectY  = rectY;
+    levels[depth].scroll = scroll;
+    depth++;
+
+    openLevel(m);
+    menuTone();
 }
 
 
@@ -766,14 +1843,18 @@ void exitMain() {
 =====================
 */
 void leaveMenu() {
+    if (depth == 0) return;
+
+    // Back to the parent, where it was left
+    depth--;
+    openLevel(levels[depth].menu);
+    cursor = levels[depth].cursor;
+    rectY  = levels[depth].rectY;
+    scroll = levels[depth].scroll;
+    menuTone();
 
-    // Back to menu
-    cursor          = _cr;
-    rectY           = _ry;
-    scroll          = _sl;
-    redraw = true;
+    invalidate(DIRTY_ALL);
     rotary_accel = false;
-    inMenu = true;
     buttonPressed_i = 0;
 }
 
@@ -798,16 +1879,98 @@ void countUpFast() {
 }
 
 
+/*
+=====================
+ long accelStep
+=====================
+*/
+// Detent interval to speed: 0 below one detent each ACCEL_SLOW ms,
+// one more level each time the interval halves.
+//
+//   ms      >=120  60  30  15  <15
+//   level     0     1   2   3   4
+
+uint8_t speedLevel(uint16_t ms) {
+    uint8_t level = 0;
+
+    for (uint16_t t = ACCEL_SLOW; ms < t && level < ACCEL_LEVELS - 1; t /= 2)
+        level++;
+    return level;
+}
+
+// Step for the next detent. Slow turns are always one.
+long accelStep(const MenuItem *it) {
+    uint8_t level = speedLevel(detentInterval());
+
+    if (level == 0) return 1;
+
+    switch (itemAccel(it)) {
+        case ACCEL_LOG:
+            // 1/64 to 1/8 of the value: about 20 detents a decade
+            return max(max(labs(valueOf(it)), 64L) >> (7 - level), 1L);
+
+        case ACCEL_DECADE: {
+            // Top speed moves the first digit of the range
+            uint8_t digits = 0;
+            long step = 1;
+
+            for (long r = itemMax(it) - itemMin(it); r >= 10; r /= 10)
+                digits++;
+            for (uint8_t d = level * digits / (ACCEL_LEVELS - 1); d > 0; d--)
+                step *= 10;
+            return step;
+        }
+    }
+    return 1;
+}
+
+
+/*
+=====================
+ void stepValue
+=====================
+*/
+// All the detents of a frame at once. The value is clamped before the
+// product can overflow, so a burst of any size lands on min or max.
+void stepValue(int16_t detents) {
+    const MenuItem *it = itemAt(cursor);
+    long step = accelStep(it);
+    long v = valueOf(it);
+    long lo = itemMin(it), hi = itemMax(it);
+    uint16_t n = abs(detents);
+
+    if (n == 0) return;
+
+    if (itemAccel(it) == ACCEL_DECADE && step > 1) {
+        // Stay on the digit: 12345 +100 -> 12400, -100 -> 12300,
+        // -12345 +100 -> -12300. The remainder is taken below v.
+        long r = ((v % step) + step) % step;
+
+        if (detents > 0) v += step - r;
+        else v -= r ? r : step;
+        n--;
+    }
+
+    if (detents > 0) v = (hi - v) / step < n ? hi : v + n * step;
+    else v = (v - lo) / step < n ? lo : v - n * step;
+
+    v = constrain(v, lo, hi);
+    if (v != valueOf(it)) {
+        valueOf(it) = v;
+        setMask(it, Modified, true);
+    }
+    // Refresh, once for the whole frame
+    invalidate(DIRTY_VALUE);
+}
+
+
 /*
 =====================
  void countUp
 =====================
 */
 void countUp() {
-    MenuItem *it = itemsList[cursor];
-    if (it->val < it->max) it->val++;
-    // Refresh
-    option();
+    stepValue(1);
 }
 
 
@@ -817,10 +1980,7 @@ void countUp() {
 =====================
 */
 void countDown() {
-    MenuItem *it = itemsList[cursor];
-    if (it->val > it->min) it->val--;
-    // Refresh
-    option();
+    stepValue(-1);
 }
 
 
@@ -832,10 +1992,9 @@ void countDown() {
 void closeItem() {
     // Re-drawing is in loop()
     redraw = true;
-    encoder->setAccelerationEnabled(false);
+    invalidate(DIRTY_ALL);
     rotary_accel = false;
-    buttonPressed_i = 1;
-    inMenu = false;
+    buttonPressed_i = 0;
 }
 
 
@@ -844,34 +2003,44 @@ void closeItem() {
  void setItem 
 =====================
 */
-// Visualizza il nuovo valore con countUp e countDown
+// Visualizza il nuovo valore con countUp e countDown. Once the row is
+// drawn only the value field is cleared and printed again.
+const char prompts[4][13] PROGMEM = {
+    " ON    <OFF>", "<ON>    OFF ", " YES    <NO>", "<YES>    NO "
+};
+
 void option() {
-    MenuItem *it = itemsList[cursor];
-    const char *prompt[][4] = {{ " ON    <OFF>" }, { "<ON>    OFF " },
-        { " YES    <NO>" },{ "<YES>    NO " }
-    };
+    const MenuItem *it = itemAt(cursor);
+    char prompt[sizeof(prompts[0])];
+    const char *text;
+    uint8_t w;
+    int x = MARGIN_L * 2, y = MENU_H * rectY + CENTER_TEXT;
+
+    // Nothing changed
+    if ((dirty & DIRTY_VALUE) == 0) return;
+    dirty &= ~DIRTY_VALUE;
        
     display.invertText(true);
-    drawRect();
+    if (valueX < 0) drawRect();
+    else display.fillRect(valueX, y, valueW, FONT_H);
     
-    if (hasMask(it, OnOff))
-                            display.print(*prompt[it->val], 
-                            MARGIN_L * 2, 
-                            MENU_H * rectY + CENTER_TEXT);
-    else if (hasMask(it, YesNo))
-                            display.print(*prompt[it->val+2], 
-                            MARGIN_L * 2, 
-                            MENU_H * rectY + CENTER_TEXT);
-    else {
+    if (hasMask(it, OnOff) || hasMask(it, YesNo)) {
+        strcpy_P(prompt, prompts[valueOf(it) + (hasMask(it, YesNo) ? 2 : 0)]);
+        text = prompt;
+        w = strlen(text) * FONT_W;
+    } else {
         // DON'T USE printNumI. Strange pixel appear at the bottom
         // in the right corner of the screen.
-        char num[10] = { 0 };   
-        ltoa(it->val, num, 10);
-        display.print(num, CENTER, MENU_H * rectY + CENTER_TEXT);
+        text = previews.get(itemId(it), valueOf(it), itemFormat(it), FONT_W, w);
+        x = (SCR_WIDTH - w) / 2;
     }
 
+    display.print(text, x, y);
+    valueX = x;
+    valueW = w;
 
-    display.update();
+    frames++;
+    updateScreen();
 }
 
 
@@ -880,16 +2049,20 @@ void option() {
  void openItem
 =====================
 */
-void openItem(MenuItem *mi) {
+void openItem(const MenuItem *mi) {
     if (isLocked(mi))
         return;
-        
-    encoder->setAccelerationEnabled(true);
+
+    // Draw the value when it opens
+    if (!rotary_accel) {
+        invalidate(DIRTY_VALUE);
+        valueX = -1;
+    }
 
     rotary_accel = true;
     redraw = false;
 
-    mi->action();
+    runItem(mi);
 }
 
 
@@ -899,61 +2072,102 @@ void openItem(MenuItem *mi) {
 =====================
 */
 void drawRect() {
-    // There is no fillRect() like in Adafruit_gfx library.
-    // Draw a rectangle increasing gradually the width
-    // so that it appears filled.
-    for (int i = 0; i < SCR_WIDTH; i++) {
-        //display.drawRect(0, (MENU_H * rectY),
-        //  i, (MENU_H * rectY) + startY + MENU_H - 1);
-        display.drawLine(i, (MENU_H * rectY), i, (MENU_H * rectY) + startY + MENU_H);
-    }
+    // One menu row is exactly two pages of the framebuffer.
+    display.fillRect(0, MENU_H * rectY + startY, SCR_WIDTH, MENU_H);
 }
 
 typedef struct {
     boolean isPressed,
             isReleased,
-            isClicked,
             isHeld;
-    unsigned long pressedTime;
+    uint8_t clicks,
+            doubles,
+            repeats;
+    int16_t delta;
+    unsigned long lastDetent;   // ISR time of the last detent, us
+    uint16_t interval;          // ms between the last two
 } EncoderButton;
 
 EncoderButton button;
 
 
+// Consume the events queued by timerIsr. Pressed and released last
+// one pass, clicks and detents are kept until someone reads them.
 void updateButton() {
-    static int stateA = LOW;
-    int stateB = (PINB & (1 << PINB0) ? LOW : HIGH);
-    
-    if (stateB == HIGH && stateA == LOW) {
-        button.isPressed = true;
-        button.pressedTime = millis();
-    } else {
-        button.isPressed = false;
-    }
-
-    if (stateB == LOW && stateA == HIGH) {
-        button.isReleased = true;
-        if (millis() - button.pressedTime < BUTTON_HOLDTIME) {
-            button.isClicked = true;
+    InputEvent ev;
+
+    button.isPressed = false;
+    button.isReleased = false;
+
+    while (events.pop(ev)) {
+        switch (ev.type) {
+            case EV_DETENT:
+                button.delta += ev.value;
+                button.interval = min((ev.time - button.lastDetent) / 1000, 0xffffUL);
+                button.lastDetent = ev.time;
+                break;
+            case EV_PRESS:
+                button.isPressed = true;
+                break;
+            case EV_RELEASE:
+                button.isReleased = true;
+                button.isHeld = false;
+                break;
+            case EV_CLICK:
+                button.clicks++;
+                break;
+            case EV_HOLD:
+                button.isHeld = true;
+                break;
+            case EV_DOUBLE:
+                // Still a click for who doesn't ask
+                button.clicks++;
+                button.doubles++;
+                break;
+            case EV_REPEAT:
+                button.repeats++;
+                break;
         }
-    } else {
-        button.isReleased = false;
-        button.isClicked = false;
     }
 
-    button.isHeld = (stateB == HIGH && millis() - button.pressedTime >= BUTTON_HOLDTIME);
-
-    stateA = stateB;
+    // Newer than anything in the queue
+    button.delta += encoder.take();
 }
 
 boolean buttonClicked() {
-    if (button.isClicked) {
-        button.isClicked = false;
+    if (button.clicks > 0) {
+        button.clicks--;
+        return true;
+    }
+    return false;
+}
+
+// Only the second click of the two, the first one was a click
+boolean buttonDoubleClicked() {
+    if (button.doubles > 0) {
+        button.doubles--;
         return true;
     }
     return false;
 }
 
+// Repeats while held since the last call
+uint8_t buttonRepeat() {
+    uint8_t n = button.repeats;
+    button.repeats = 0;
+    return n;
+}
+
+uint16_t detentInterval() {
+    return button.interval;
+}
+
+int16_t rotaryDelta() {
+    int16_t delta = button.delta;
+    button.delta = 0;
+    return delta;
+}
+
 boolean buttonHold() {
     return button.isHeld;
 }
@@ -972,7 +2186,7 @@ void drawImage(const char *icon) {
 
     display.invertText(true);
     display.print(icon, CENTER, MENU_H * rectY + CENTER_TEXT);
-    display.update();
+    updateScreen();
 }
 
 /*
@@ -981,14 +2195,19 @@ void drawImage(const char *icon) {
 =====================
 */
 void window() {
-    MenuItem *mi;
+    const MenuItem *mi = itemAt(cursor);
+#if DEBUG_STATS
+    unsigned long sent = display.bytesSent;
+#endif
+
+    updateButton();
     
     // Menu aperto
-    if (!inMenu) {
-        mi = itemsList[cursor];
-
+    if (depth > 0) {
         if (isLocked(mi)) {
             stopPressEvent = true;
+            // Clicks don't open a locked item
+            button.clicks = button.doubles = 0;
 
             if (buttonPressed()) drawImage("X");
 
@@ -1009,27 +2228,40 @@ void window() {
     } 
 
     // Encoder rotativo
-    int16_t delta = rotary_off ? 0 : encoder->getValue();
+    int16_t delta = rotary_off ? 0 : rotaryDelta();
+    int8_t sl = scroll;
+#if SMOOTH_SCROLL
+    int8_t ry = rectY;
+#endif
     
     if (delta != 0 && !buttonReleased()) {
+        // The value takes the whole delta at once, the cursor one
+        // row for each detent
         if (rotary_accel)
-          (delta < 0) ? countDown() : countUp();
+            stepValue(delta);
         else
-          (delta < 0) ? cursorUp() : cursorDown();
+            for (int16_t n = abs(delta); n > 0; n--)
+                (delta < 0) ? cursorUp() : cursorDown();
         // Resettare dopo drawImage 
         redraw = true; 
+        if (rotary_accel) invalidate(DIRTY_VALUE);
+        else invalidate(scroll != sl ? DIRTY_SCROLL : DIRTY_CURSOR);
+#if SMOOTH_SCROLL
+        if (!rotary_accel && depth > 0) slide(scroll - sl, ry - rectY);
+#endif
     } else { stopPressEvent = false; }
 
     // Browse menu
     switch (buttonPressed_i) {
         case 0: 
-            drawMenus();
+            if (depth == 0) drawMenus();
+            else drawItems();
             break;
         case 1:
             openMenu();
             break;
         case 2:
-            openItem(mi); 
+            openItem(itemAt(cursor)); 
             break;
         case 3:
             closeItem();
@@ -1040,78 +2272,256 @@ void window() {
             break;
     }
   
-  
-    updateButton();
-
-    // Get rid of delay
-    if (buttonPressed_i != 1) delay(100);
+    // Nobody reads the encoder here
+    if (rotary_off) rotaryDelta();
 
     // Manage items stuff here
     checkMe();
+
+#if DEBUG_STATS
+    if (delta != 0) printStat("I2C bytes", display.bytesSent - sent);
+#endif
 }
 
 
 /*
 =====================
- uint8_t createList
+ void drawMenus
 =====================
 */
-uint8_t createList(MenuItem *lst[]) {
-    int cnt = 0;
-    
-    // Clear list
-    for (int i = 0; i < MAX_ITEMS; i++) lst[i] = NULL;
-    arrayLen = 0;
-       
-    // Create new list      
-    for (int i = 0; i < menus[indexMenu].items; i++) {
-        MenuItem *it = &menus[indexMenu].item[i];
-        // Skip them
-        if (hasMask(it, Hide)) // || hasMask(it, Label))
-            continue;
-        lst[cnt] = it;
-        cnt++;
+void drawMenus() {   
+    int y = startY;
+
+    if (dirty == 0) return;
+
+    if (dirty & ~DIRTY_CURSOR) {
+        display.clrScr();
+        display.invertText(false);
+
+        // Only the rows on screen
+        for (int i = scroll; i < min(arrayLen, scroll + screenEnd); i++) {
+            labels.print(display, itemText(itemAt(i)), MARGIN_L*2, y + CENTER_TEXT);
+            y = y + MENU_H;
+        }
+    } else {
+        // Only the marker and the scrollbar moved
+        display.fillRect(0, 0, MARGIN_L * 2, SCR_HEIGHT, FILL_CLEAR);
+        display.fillRect(SCR_WIDTH - 4, 0, 4, SCR_HEIGHT, FILL_CLEAR);
     }
 
-    return cnt;
+    display.print(">", 0, MENU_H * rectY + CENTER_TEXT);
+    drawScrollbar();
+
+    dirty = 0;
+    frames++;
+    updateScreen();
 }
 
 
 /*
 =====================
- void drawMenus
+ void scrollText
 =====================
 */
-void drawMenus() {   
-    int y = startY;
-    arrayLen = LIST(menus);
+// Scorrimento del testo dell'item selezionato. Only the text area of
+// its row is drawn and sent, whatever else is on the screen.
+void scrollText() {
+    const MenuItem *it;
+
+    if (depth == 0 || arrayLen == 0) return;
+    // An item is open, the screen is frozen or the list is sliding
+    if (buttonPressed_i != 0 || !redraw || listSlide || barSlide) return;
+
+    it = itemAt(cursor);
+    if (!hasMask(it, Item) || !hasMask(it, Scrolling)) return;
+
+    if (marquee.step(display, labels, itemText(it), SCROLL_X,
+                     startY + MENU_H * rectY + CENTER_TEXT, SCROLL_W,
+                     SCROLL_STEP))
+        updateScreen();
+}
 
-    display.clrScr();
-    display.invertText(false);
-    display.print(">", 0, MENU_H * rectY + CENTER_TEXT);
-    drawScrollbar();
 
-    for (int i = scroll; i < arrayLen; i++) {
-        display.print(menus[i].text, MARGIN_L*2, y + CENTER_TEXT);
-        y = y + MENU_H;
+/*
+=====================
+ void drawRow
+=====================
+*/
+// Una riga della lista
+void drawRow(int8_t i, int y, boolean selected) {
+    display.fillRect(0, y, SCR_WIDTH, MENU_H,
+                     selected ? FILL_SET : FILL_CLEAR);
+    drawText(i, y, selected);
+}
+
+// The text of a row, over what is there
+void drawText(int8_t i, int y, boolean selected) {
+    const MenuItem *it = itemAt(i);
+    boolean preview = true;
+
+    display.invertText(selected);
+    //
+    // Scroll content
+    //
+    if (selected && hasMask(it, Item)
+                 && hasMask(it, Scrolling)) {
+      preview = false;
+
+      // Where the marquee is now
+      if (!marquee.draw(display, labels, itemText(it), SCROLL_X,
+                        y + CENTER_TEXT, SCROLL_W))
+        labels.print(display, itemText(it), MARGIN_L, y + CENTER_TEXT);
+    } else { 
+        //
+        // Print setting
+        //
+        labels.print(display, itemText(it), MARGIN_L, y + CENTER_TEXT);
+
+        // print() doesn't clip, a sliding row may be half out
+        if (y < 0 || y + MENU_H > SCR_HEIGHT) preview = false;
+        
+        if (preview && hasValue(it)) {
+            uint8_t fw;
+            const char *option = previews.get(itemId(it), valueOf(it),
+                                              itemFormat(it), FONT_W, fw);
+      
+            // Print on the right screen
+            display.print(option, MARGIN_R - fw - MARGIN_L, y + CENTER_TEXT);
+        }
     }
+}
 
-    _cr = cursor;
-    _ry = rectY;
-    _sl = scroll;
+void drawItem(int8_t i) {
+    drawRow(i, startY + MENU_H * (i - scroll), cursor == i);
+}
 
-    display.update();
+// Where drawText() puts the text of the rows from first to last,
+// offset pixels from their place, plain: the labels end before lab,
+// the values start at val.
+void textSpans(int8_t first, int8_t last, int8_t offset,
+               uint8_t &lab, uint8_t &val) {
+    for (int8_t i = first; i < last; i++) {
+        const MenuItem *it = itemAt(i);
+        int y = startY + MENU_H * (i - scroll) + offset;
+        uint8_t fw;
+
+        if (y <= -MENU_H || y >= SCR_HEIGHT) continue;
+        lab = max((int)lab, MARGIN_L + (int)strlen_P(itemText(it)) * FONT_W);
+
+        // The preview only on a whole row
+        if (y < 0 || y + MENU_H > SCR_HEIGHT) continue;
+        if (hasValue(it)) {
+            previews.get(itemId(it), valueOf(it), itemFormat(it), FONT_W, fw);
+            val = min((int)val, TEXT_END - fw);
+        }
+    }
+}
+
+
+/*
+=====================
+ void moveBar
+=====================
+*/
+// The bar from drawnBar to y over the rows in place. Only the strips
+// it leaves and covers are inverted, ANIM_STEP pixels high each: two
+// pages of the panel for a frame, not the rows.
+//
+//   drawnBar  ______       y  ______
+//            |######|  ->    |      |  <- strip left
+//            |######|        |######|
+//            |______|        |######|
+//                            |######|  <- strip covered
+// The bar from one place to the other in the columns x to x + w
+void invertBar(int x, int w, int8_t from, int8_t to) {
+    int8_t d = abs(to - from);
+
+    if (w <= 0 || d == 0) return;
+    if (d < MENU_H) {
+        display.fillRect(x, min(to, from), w, d, FILL_INVERT);
+        display.fillRect(x, min(to, from) + MENU_H, w, d, FILL_INVERT);
+    } else {
+        display.fillRect(x, from, w, MENU_H, FILL_INVERT);
+        display.fillRect(x, to, w, MENU_H, FILL_INVERT);
+    }
+}
+
+// The selected row of drawnTop as a plain row under the bar. It is
+// already, but for the marquee of a scrolling item.
+void barFromSelection() {
+    const MenuItem *it = itemAt(drawnCursor);
+    int8_t y = startY + MENU_H * (drawnCursor - drawnTop);
+
+    if (hasMask(it, Item) && hasMask(it, Scrolling)) {
+        drawRow(drawnCursor, y, false);
+        display.fillRect(0, y, SCR_WIDTH, MENU_H, FILL_INVERT);
+    }
+    drawnBar = y;
+}
+
+// At rest the other way round, the row under the bar is the selected
+// row
+void barAtRest() {
+    const MenuItem *it = itemAt(cursor);
+
+    if (hasMask(it, Item) && hasMask(it, Scrolling)) drawItem(cursor);
+    drawnBar = NO_BAR;
+}
+
+void moveBar(int8_t y) {
+    if (drawnBar == NO_BAR) barFromSelection();
+    invertBar(0, SCR_WIDTH, drawnBar, y);
+    drawnBar = y;
+
+    if (barSlide == 0) barAtRest();
 }
 
 
 /*
 =====================
- void clearRect
+ void slideRows
 =====================
 */
-void clearRect() {
-    memset(rectbuf, ' ', BUFSIZE);
-    rectbuf[BUFSIZE - 1] = '\0';
+// The rows ANIM_STEP pixels on, the bar to y. Everything on screen
+// moves but only the text changes: the columns of the labels and of
+// the values, old and new, are cleared and drawn again on every page,
+// the bar inverted over them. Outside them the bar slides as in
+// moveBar(). A frame sends the text columns, not the screen.
+//
+//   |   LABEL            12   |
+//   |   ITEM #########   ##   |   <- cleared and drawn, all the height
+//   |   LABEL                 |
+//    ^^^               ^^^  ^^^  <- only the bar, if it moves
+void slideRows(int8_t y) {
+    int8_t first = max(scroll - 1, 0);
+    int8_t last = min(arrayLen, scroll + screenEnd + 1);
+    uint8_t lab = MARGIN_L, val = TEXT_END;
+
+    if (drawnBar == NO_BAR) barFromSelection();
+    textSpans(first, last, listSlide, lab, val);
+
+    // Old and new text: one span when they meet
+    uint8_t l = max(lab, drawnLabels), v = min(val, drawnValues);
+    if (l >= v) l = v = TEXT_END;
+
+    display.fillRect(MARGIN_L, 0, l - MARGIN_L, SCR_HEIGHT, FILL_CLEAR);
+    display.fillRect(v, 0, TEXT_END - v, SCR_HEIGHT, FILL_CLEAR);
+
+    for (int8_t i = first; i < last; i++)
+        drawText(i, startY + MENU_H * (i - scroll) + listSlide, false);
+
+    display.fillRect(MARGIN_L, y, l - MARGIN_L, MENU_H, FILL_INVERT);
+    display.fillRect(v, y, TEXT_END - v, MENU_H, FILL_INVERT);
+    invertBar(0, MARGIN_L, drawnBar, y);
+    invertBar(l, v - l, drawnBar, y);
+    invertBar(TEXT_END, SCR_WIDTH - TEXT_END, drawnBar, y);
+
+    drawnBar = y;
+    drawnLabels = lab;
+    drawnValues = val;
+    drawnTop = listSlide ? -1 : scroll;
+
+    if (listSlide == 0 && barSlide == 0) barAtRest();
 }
 
 
@@ -1121,112 +2531,144 @@ void clearRect() {
 =====================
 */
 void drawItems() { 
-    MenuItem *it;
-    boolean preview = true;
-    int y = startY;
-  
-    if (redraw == false) return;
-    display.clrScr();
+    int8_t bar = startY + MENU_H * rectY + barSlide;
+
+    if (redraw == false || dirty == 0) return;
+
+    boolean sliding = listSlide || barSlide || drawnBar != NO_BAR;
+    boolean known = drawnTop >= 0 || drawnBar != NO_BAR;
+
+    if (!(dirty & DIRTY_LIST) && listSlide == 0 && drawnTop == scroll
+        && (barSlide || drawnBar != NO_BAR)) {
+        // The rows stay, only the bar slides
+        moveBar(bar);
+    } else if (!(dirty & DIRTY_LIST) && sliding && known) {
+        // Between two places: the rows are drawn plain, one more on
+        // each side, and the bar inverts what is under it
+        slideRows(bar);
+    } else if (sliding) {
+        // Nothing known on screen: no text, the bar, then the rows
+        display.clrScr();
+        display.fillRect(0, bar, SCR_WIDTH, MENU_H, FILL_INVERT);
+        drawnBar = bar;
+        drawnLabels = MARGIN_L;
+        drawnValues = TEXT_END;
+        slideRows(bar);
+    } else if (dirty & (DIRTY_SCROLL | DIRTY_LIST)) {
+        display.clrScr();
+
+        // Only the rows on screen
+        for (int i = scroll; i < min(arrayLen, scroll + screenEnd); i++)
+            drawItem(i);
+        drawnTop = scroll;
+        drawnBar = NO_BAR;
+        drawnLabels = MARGIN_L;
+        drawnValues = TEXT_END;
+        textSpans(scroll, min(arrayLen, scroll + screenEnd), 0,
+                  drawnLabels, drawnValues);
+    } else {
+        // Same rows: the old and the new selection
+        if (drawnCursor != cursor) drawItem(drawnCursor);
+        drawItem(cursor);
+        textSpans(scroll, min(arrayLen, scroll + screenEnd), 0,
+                  drawnLabels, drawnValues);
+    }
 
-    drawRect();
+    drawnCursor = cursor;
+    dirty = 0;
+    frames++;
+    updateScreen();
+}
 
-    for (int i = scroll; i < arrayLen; i++) { 
-        it = itemsList[i];
-    
-        display.invertText(cursor == i);
-        preview = true;
-        //
-        // Scroll content
-        //
-        if (cursor == i && hasMask(it, Item)
-                        && hasMask(it, Scrolling)) {
-          preview = false;
-      
-          clearRect();
-      
-          // [<-               ]
-          if (direction == 0) {
-            head++;
-            tail = strlen(it->text) - head;
-            if (tail <= 0) { direction = 1; head = 0; }
-            memcpy(rectbuf, it->text + head, max(0, tail));
-          } 
-          // [               <-]
-          if (direction == 1) {
-            tail = min(strlen(it->text), BUFSIZE - offset);
-            memcpy(rectbuf + offset, it->text, tail);
-            if (--offset < 0) { direction = 0; offset = BUFSIZE - 1; }
-          }
-      
-          display.print(rectbuf, MARGIN_L, y + CENTER_TEXT);
-          delay(10);
-        } else { 
-            //
-            // Print setting
-            //
-            display.print(it->text, MARGIN_L, y + CENTER_TEXT); 
-            
-            if (preview   &&  hasMask(it, Item)
-                          && !hasMask(it, Button)
-                          && !hasMask(it, Label)) { 
-                char option[10] = { 0 };
-        
-                if (hasMask(it, OnOff))
-                  sprintf(option, "%s", it->val == 1 ? "ON" : "OFF");
-                else if (hasMask(it, YesNo))
-                  sprintf(option, "%s", it->val == 1 ? "YES" : "NO");
-                else
-                  sprintf(option, "%ld", it->val);
-          
-                // Print on the right screen
-                int fw = strlen(option) * FONT_W;
-                display.print(option, MARGIN_R - fw - MARGIN_L, y + CENTER_TEXT);
-            }
-        }
 
-        y = y + MENU_H;
+/*
+=====================
+ void slide
+=====================
+*/
+// Start sliding from the old place: rows and bar are drawn moved back
+// by the jump and get to their place ANIM_STEP pixels for each frame.
+// New input adds to what is left, and never more than a row is left,
+// so the list is where the encoder says within 2 * MENU_H / ANIM_STEP
+// frames: first the list, then the bar, never both in a frame.
+void slide(int8_t rows, int8_t bars) {
+    listSlide = constrain(listSlide + rows * MENU_H, -MENU_H, MENU_H);
+    barSlide  = constrain(barSlide + bars * MENU_H, -MENU_H, MENU_H);
+
+    if (listSlide || barSlide) {
+        invalidate(DIRTY_SCROLL);
+        scheduler.every(animate, ANIM_PERIOD);
     }
-  
-  display.update();
+}
+
+int8_t approach(int8_t px) {
+    if (px > 0) return max(px - ANIM_STEP, 0);
+    return min(px + ANIM_STEP, 0);
 }
 
 
 /*
 =====================
- void openMenu
+ void animate
 =====================
 */
-void openMenu() {
-    MenuItem *it = menus[cursor].item;
-
-    // Prima di aprire il menu
-    if (inMenu) {
-        if (hasMask(it, Button)) {
-            it->action();
-            buttonPressed_i = 0;
-            return;
-        }
-
-        inMenu = false;
-
-        // Salva cursori
-        indexMenu = cursor;
-        arrayLen  = createList(itemsList);
-        cursor    = isLabel(0);
-        rectY     = cursor;
+// A frame of the slide. window() keeps reading the encoder meanwhile.
+void animate() {
+    // An item opened or another menu: stop where it should be
+    if (buttonPressed_i != 0 || depth == 0 || !redraw) {
+        listSlide = barSlide = 0;
+        scheduler.stop(animate);
+        return;
     }
 
-    // Disegna il menu aperto
+    // One of the two: a frame of both sends the text and the bar
+    if (listSlide) listSlide = approach(listSlide);
+    else barSlide = approach(barSlide);
+    if (listSlide == 0 && barSlide == 0) scheduler.stop(animate);
+
+    invalidate(DIRTY_SCROLL);
     drawItems();
 }
 
+
+/*
+=====================
+ void openMenu
+=====================
+*/
+void openMenu() {
+    const MenuItem *it = itemAt(cursor);
+
+    if (hasMask(it, Submenu)) {
+        buttonPressed_i = 0;
+        enterMenu(itemSub(it));
+    } else if (hasMask(it, Button)) {
+        // The action may change the state
+        buttonPressed_i = 0;
+        runItem(it);
+    } else if (hasMask(it, Item)) {
+        buttonPressed_i = 2;
+        openItem(it);
+    } else {
+        // Labels
+        buttonPressed_i = 0;
+    }
+}
+
 /*
 =====================
  void loop
 =====================
 */
 void loop() {
-    window();
+    passes++;
+    // A button gesture doesn't wait for the next frame
+    if (pushButton.gestures != gesturesSeen) {
+        gesturesSeen = pushButton.gestures;
+        scheduler.wake(window);
+    }
+    scheduler.run();
+    i2c.run();
 }
 
 // eof
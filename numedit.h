@@ -0,0 +1,397 @@
+// Number editor - Angelo Z. (2025)
+
+/*
+  Digit by digit editor for a number, on the 16x2 LCD or on the OLED.
+
+      NumberEditor<9, false, 0, LcdTarget>     000 008 000
+      NumberEditor<5, true, 2, OledTarget>    +123.45
+
+      [s ddd ddd.dd    ]   sign, digits, point
+      [^              >]   confirm, leave
+
+      START --> SELECT --click digit--> DIGIT --click--> SELECT
+                  |  \--click ^--> CONFIRM --click--> SELECT
+                  \--click >--> START (menu)
+
+  The digits are kept in BCD while editing. The value is split with
+  double dabble (shifts and adds, no division) when the editor opens,
+  and made binary again only when it is confirmed.
+
+  A target draws the cells:
+
+      begin()           before the layout
+      put(col, row, c)  one character
+      at(col, row)      the cursor
+      cursor(mode)      CURSOR_OFF, CURSOR_BLINK, CURSOR_LINE
+      width()           columns
+      ok()              confirm glyph
+
+  and sends only what changed.
+*/
+#ifndef NUMEDIT_H
+#define NUMEDIT_H
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+#include "framebuffer.h"
+
+typedef enum {
+    EDIT_START,     // Layout not drawn
+    EDIT_SELECT,    // The cursor moves between the cells
+    EDIT_DIGIT,     // The encoder turns the digit
+    EDIT_CONFIRM    // Value taken, locked
+} EditState;
+
+// click() results
+typedef enum {
+    EDIT_NONE,
+    EDIT_CONFIRMED, // value() is the new value
+    EDIT_LEFT
+} EditResult;
+
+typedef enum {
+    CURSOR_OFF,
+    CURSOR_BLINK,
+    CURSOR_LINE
+} CursorMode;
+
+
+template <uint8_t DIGITS, boolean SIGNED, uint8_t DECIMALS, class Target>
+class NumberEditor {
+public:
+    enum {
+        SIGN_CELL  = 0,                 // If SIGNED
+        FIRST      = SIGNED ? 1 : 0,    // First digit
+        OK_CELL    = FIRST + DIGITS,
+        LEAVE_CELL = OK_CELL + 1,
+        CELLS      = LEAVE_CELL + 1,
+        INTEGERS   = DIGITS - DECIMALS
+    };
+
+    NumberEditor(Target &t) : target(t) {
+        state = EDIT_START;
+    }
+
+    boolean active() {
+        return state != EDIT_START;
+    }
+
+    /*
+    =====================
+     void start
+    =====================
+    */
+    // Draw the layout with the value, cursor on the first cell
+    void start(long value) {
+        uint8_t k = 0;
+
+        target.begin();
+        split(value);
+
+        // Sign, digits in groups of three, point. The columns of the
+        // cells are kept for the cursor.
+        if (SIGNED) {
+            col[SIGN_CELL] = k;
+            target.put(k++, 0, negative ? '-' : '+');
+        }
+        for (uint8_t i = 0; i < DIGITS; i++) {
+            if (i == INTEGERS && DECIMALS)
+                target.put(k++, 0, '.');
+            else if (i && i < INTEGERS && (INTEGERS - i) % 3 == 0)
+                target.put(k++, 0, ' ');
+
+            col[FIRST + i] = k;
+            target.put(k++, 0, '0' + digits[i]);
+        }
+        target.put(0, 1, target.ok());
+        target.put(target.width() - 1, 1, '>');
+
+        x = 0;
+        state = EDIT_SELECT;
+        moveTo(x);
+        target.cursor(CURSOR_BLINK);
+    }
+
+    // The cursor off first: on the OLED it is drawn over the cells
+    void stop() {
+        if (state == EDIT_SELECT || state == EDIT_DIGIT) target.cursor(CURSOR_OFF);
+        state = EDIT_START;
+    }
+
+    /*
+    =====================
+     void show
+    =====================
+    */
+    // Another value, only the digits that differ are written
+    void show(long value) {
+        uint8_t old[DIGITS];
+        boolean sign = negative;
+
+        memcpy(old, digits, DIGITS);
+        split(value);
+
+        if (SIGNED && sign != negative)
+            target.put(col[SIGN_CELL], 0, negative ? '-' : '+');
+        for (uint8_t i = 0; i < DIGITS; i++)
+            if (old[i] != digits[i]) target.put(col[FIRST + i], 0, '0' + digits[i]);
+
+        moveTo(x);
+    }
+
+    /*
+    =====================
+     void turn
+    =====================
+    */
+    void turn(int16_t delta) {
+        if (delta == 0) return;
+
+        if (state == EDIT_SELECT) {
+            int8_t to = (x + delta) % CELLS;
+            if (to < 0) to += CELLS;
+            if (to != x) moveTo(to);
+        } else if (state == EDIT_DIGIT) {
+            if (SIGNED && x == SIGN_CELL) {
+                // Each detent flips it
+                if (delta & 1) negative = !negative;
+                target.put(col[x], 0, negative ? '-' : '+');
+            } else {
+                int8_t d = digits[x - FIRST] + delta % 10;
+                if (d < 0) d += 10;
+                else if (d > 9) d -= 10;
+                digits[x - FIRST] = d;
+                target.put(col[x], 0, '0' + d);
+            }
+            moveTo(x);
+        }
+    }
+
+    /*
+    =====================
+     uint8_t click
+    =====================
+    */
+    uint8_t click() {
+        switch (state) {
+            case EDIT_SELECT:
+                if (x == OK_CELL) {
+                    state = EDIT_CONFIRM;
+                    target.cursor(CURSOR_OFF);
+                    return EDIT_CONFIRMED;
+                }
+                if (x == LEAVE_CELL) {
+                    stop();
+                    return EDIT_LEFT;
+                }
+                state = EDIT_DIGIT;
+                target.cursor(CURSOR_LINE);
+                break;
+            case EDIT_DIGIT:
+            case EDIT_CONFIRM:
+                state = EDIT_SELECT;
+                target.cursor(CURSOR_BLINK);
+                break;
+        }
+        return EDIT_NONE;
+    }
+
+    /*
+    =====================
+     long value
+    =====================
+    */
+    // BCD to binary, n * 10 as (n << 3) + (n << 1)
+    long value() {
+        unsigned long n = 0;
+
+        for (uint8_t i = 0; i < DIGITS; i++)
+            n = (n << 3) + (n << 1) + digits[i];
+        return negative ? -(long) n : n;
+    }
+
+protected:
+    Target &target;
+    uint8_t state;
+    int8_t x;                   // Cell
+    boolean negative;
+    uint8_t digits[DIGITS];     // BCD, one digit in each byte
+    uint8_t col[FIRST + DIGITS];
+
+    void moveTo(int8_t cell) {
+        x = cell;
+        if (cell == OK_CELL) target.at(0, 1);
+        else if (cell == LEAVE_CELL) target.at(target.width() - 1, 1);
+        else target.at(col[cell], 0);
+    }
+
+    // Double dabble: for each bit, from the top, every digit over 4
+    // gets 3 more and the whole BCD number is shifted left.
+    void split(long value) {
+        unsigned long n;
+
+        negative = SIGNED && value < 0;
+        n = value < 0 ? (SIGNED ? -(unsigned long) value : 0) : value;
+
+        memset(digits, 0, DIGITS);
+
+        for (uint8_t b = 0; b < 32; b++) {
+            uint8_t carry = (n & 0x80000000UL) != 0;
+            n <<= 1;
+
+            for (int8_t i = DIGITS - 1; i >= 0; i--) {
+                uint8_t d = digits[i];
+                if (d >= 5) d += 3;
+                d = d << 1 | carry;
+                carry = d >> 4;
+                digits[i] = d & 0x0f;
+            }
+            // Doesn't fit: all nines
+            if (carry) {
+                memset(digits, 9, DIGITS);
+                return;
+            }
+        }
+    }
+};
+
+
+/*
+=====================
+ LcdTarget
+=====================
+*/
+// Every LCD byte is two nibbles, each one three expander writes
+// (data, enable high, enable low) of address + data on the bus.
+#define LCD_BUS_BYTES 12
+#define LCD_WIDTH     16
+#define NO_POSITION   0xff
+
+class LcdTarget {
+public:
+    // Statistics: bus bytes, commands to the LCD
+    unsigned long bytes;
+    unsigned long writes;
+
+    LcdTarget(LiquidCrystal_I2C &l) : lcd(l) {
+        bytes = writes = 0;
+        cc = cr = NO_POSITION;
+    }
+
+    void begin() {
+        byte bell[] = {
+            B00100,
+            B01110,
+            B01110,
+            B01110,
+            B11111,
+            B00000,
+            B00100,
+            B00000
+        };
+        lcd.createChar(0, bell);
+        // createChar leaves the address in the CGRAM
+        cc = cr = NO_POSITION;
+        send(1 + sizeof(bell));
+    }
+
+    // The address moves on by itself after a write: characters side by
+    // side need no setCursor()
+    void put(uint8_t c, uint8_t r, char ch) {
+        at(c, r);
+        lcd.write(ch);
+        cc++;
+        send(1);
+    }
+
+    void at(uint8_t c, uint8_t r) {
+        if (c == cc && r == cr) return;
+        lcd.setCursor(c, r);
+        cc = c;
+        cr = r;
+        send(1);
+    }
+
+    void cursor(uint8_t mode) {
+        if (mode == CURSOR_LINE) lcd.cursor(); else lcd.noCursor();
+        if (mode == CURSOR_BLINK) lcd.blink(); else lcd.noBlink();
+        send(2);
+    }
+
+    uint8_t width() { return LCD_WIDTH; }
+    char ok()       { return 0; }   // The bell
+
+protected:
+    LiquidCrystal_I2C &lcd;
+    uint8_t cc, cr;                 // Address of the LCD
+
+    void send(uint8_t n) {
+        bytes += n * LCD_BUS_BYTES;
+        writes++;
+    }
+};
+
+
+/*
+=====================
+ OledTarget
+=====================
+*/
+// Two text lines of the OLED from y. The cursor is drawn with XOR:
+// a block for CURSOR_BLINK, a line under the cell for CURSOR_LINE.
+class OledTarget {
+public:
+    OledTarget(PagedOLED &d, int y0) : display(d) {
+        y = y0;
+        mode = CURSOR_OFF;
+        cc = cr = 0;
+    }
+
+    void begin() {
+        display.fillRect(0, y, OLED_COLS, 16, FILL_CLEAR);
+        mode = CURSOR_OFF;
+    }
+
+    void put(uint8_t c, uint8_t r, char ch) {
+        char s[2] = { ch, '\0' };
+
+        // The character covers the whole cell, cursor included
+        display.invertText(false);
+        display.print(s, c * display.fontWidth(), y + r * 8);
+        if (c == cc && r == cr) mark();
+    }
+
+    void at(uint8_t c, uint8_t r) {
+        mark();
+        cc = c;
+        cr = r;
+        mark();
+    }
+
+    void cursor(uint8_t m) {
+        mark();
+        mode = m;
+        mark();
+    }
+
+    uint8_t width() { return OLED_COLS / display.fontWidth(); }
+    char ok()       { return '^'; }
+
+protected:
+    PagedOLED &display;
+    int y;
+    uint8_t mode;
+    uint8_t cc, cr;
+
+    // XOR: the same call draws and erases
+    void mark() {
+        uint8_t w = display.fontWidth();
+
+        if (mode == CURSOR_BLINK)
+            display.fillRect(cc * w, y + cr * 8, w, 8, FILL_INVERT);
+        else if (mode == CURSOR_LINE)
+            display.fillRect(cc * w, y + cr * 8 + 7, w, 1, FILL_INVERT);
+    }
+};
+
+#endif
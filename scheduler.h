@@ -0,0 +1,175 @@
+// Scheduler - Angelo Z. (2025)
+
+/*
+  Cooperative millis() scheduler.
+
+  loop() only calls run(). A task is a plain function that must return
+  quickly; periodic tasks are re-armed with their period, one-shot
+  tasks (period 0) are released after running.
+
+      every(window, 40)     run window() each 40 ms
+      after(lampOff, 100)   run lampOff() once, 100 ms from now
+
+  A task started later than its deadline counts as an overrun.
+
+  RAM  MAX_TASKS * 8 bytes, 16 with TASK_STATS
+*/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#ifndef MAX_TASKS
+#define MAX_TASKS 8
+#endif
+#ifndef TASK_STATS
+#define TASK_STATS 1   // deadline and the counters, for report()
+#endif
+
+
+typedef struct {
+    void (*run)(void);
+    unsigned long next;
+    uint16_t period;        // 0 = one-shot
+#if TASK_STATS
+    uint16_t deadline;      // Allowed lateness
+    uint16_t runs;
+    uint16_t overruns;
+    uint16_t maxLate;
+#endif
+} Task;
+
+
+class Scheduler {
+public:
+    Scheduler() {
+        for (uint8_t i = 0; i < MAX_TASKS; i++) tasks[i].run = NULL;
+    }
+
+    /*
+    =====================
+     Task *every
+    =====================
+    */
+    // Periodic task. The deadline defaults to the period.
+    Task *every(void (*fn)(void), uint16_t period, uint16_t deadline = 0) {
+        return add(fn, period, period, deadline ? deadline : period);
+    }
+
+    /*
+    =====================
+     Task *after
+    =====================
+    */
+    // One-shot task. Re-arms it if it's still pending.
+    Task *after(void (*fn)(void), uint16_t ms, uint16_t deadline = 10) {
+        return add(fn, ms, 0, deadline);
+    }
+
+    /*
+    =====================
+     void stop
+    =====================
+    */
+    void stop(void (*fn)(void)) {
+        Task *t = find(fn);
+        if (t) t->run = NULL;
+    }
+
+    // Run it with the next run(), the period starts again from there
+    void wake(void (*fn)(void)) {
+        Task *t = find(fn);
+        if (t) t->next = millis();
+    }
+
+    boolean pending(void (*fn)(void)) {
+        return find(fn) != NULL;
+    }
+
+    /*
+    =====================
+     void run
+    =====================
+    */
+    void run() {
+        for (uint8_t i = 0; i < MAX_TASKS; i++) {
+            Task *t = &tasks[i];
+            unsigned long now = millis();
+
+            if (t->run == NULL || (long) (now - t->next) < 0)
+                continue;
+
+            void (*fn)(void) = t->run;
+
+#if TASK_STATS
+            unsigned long late = now - t->next;
+
+            t->runs++;
+            if (late > t->deadline) t->overruns++;
+            if (late > t->maxLate) t->maxLate = min(late, 0xffffUL);
+#endif
+
+            if (t->period == 0) {
+                t->run = NULL;
+            } else {
+                t->next += t->period;
+                // Too far behind, don't try to catch up
+                if ((long) (now - t->next) >= 0) t->next = now + t->period;
+            }
+
+            fn();
+        }
+    }
+
+    /*
+    =====================
+     void report
+    =====================
+    */
+#if TASK_STATS
+    void report(Print &out) {
+        for (uint8_t i = 0; i < MAX_TASKS; i++) {
+            Task *t = &tasks[i];
+            if (t->run == NULL) continue;
+
+            out.print(i);
+            out.print(": runs ");
+            out.print((unsigned long) t->runs);
+            out.print(" overruns ");
+            out.print((unsigned long) t->overruns);
+            out.print(" max late ");
+            out.println((unsigned long) t->maxLate);
+        }
+    }
+#endif
+
+protected:
+    Task tasks[MAX_TASKS];
+
+    Task *find(void (*fn)(void)) {
+        for (uint8_t i = 0; i < MAX_TASKS; i++)
+            if (tasks[i].run == fn) return &tasks[i];
+        return NULL;
+    }
+
+    Task *add(void (*fn)(void), uint16_t ms, uint16_t period, uint16_t deadline) {
+        Task *t = find(fn);
+
+        if (t == NULL) t = find(NULL);
+        if (t == NULL) return NULL;
+
+#if TASK_STATS
+        if (t->run != fn) {
+            t->runs = t->overruns = t->maxLate = 0;
+        }
+        t->deadline = deadline;
+#endif
+        t->run = fn;
+        t->next = millis() + ms;
+        t->period = period;
+
+        return t;
+    }
+};
+
+#endif
@@ -0,0 +1,181 @@
+// Text cache - Angelo Z. (2025)
+
+/*
+  Rasterized labels.
+
+  The labels of the menus are flash strings that never change, but
+  print() rasterizes them glyph by glyph on every frame. TextCache
+  keeps the columns of the last labels drawn in a small arena, keyed
+  by the flash address, and blits the whole run at once.
+
+      arena  [ SETTINGS......| DISPLAY.....| SAVE....|      free      ]
+      runs     text, start, len, used
+
+  When the arena or the run table is full, the least recently used
+  run is dropped and the ones after it are moved down.
+  Only fonts 8 pixels high are cached.
+*/
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <Arduino.h>
+#include "framebuffer.h"
+
+// The labels of the rows on screen: 16 letters of SmallFont. A screen
+// of longer labels misses and draws some of them glyph by glyph, the
+// same pixels. Set them with -D, larger if the RAM allows it.
+//
+//   RAM  TEXT_ARENA + TEXT_RUNS * 5 + 10    96 + 25 + 10 = 131 bytes
+#ifndef TEXT_ARENA
+#define TEXT_ARENA  96  // Bytes, one for each column
+#endif
+#ifndef TEXT_RUNS
+#define TEXT_RUNS   5
+#endif
+#define FONT_HEADER 4   // x_size, y_size, offset, numchars
+
+
+typedef struct {
+    const char *text;   // In flash, NULL = free
+    uint8_t start, len;
+    uint8_t used;       // Last use, for the LRU
+} TextRun;
+
+
+class TextCache {
+public:
+    // Statistics
+    unsigned long hits, misses;
+
+    TextCache() {
+        for (uint8_t i = 0; i < TEXT_RUNS; i++) runs[i].text = NULL;
+        fill = 0;
+        tick = 0;
+        hits = misses = 0;
+    }
+
+    /*
+    =====================
+     void print
+    =====================
+    */
+    // Same as display.print() for a flash string
+    void print(PagedOLED &display, const char *text, int x, int y) {
+        TextRun *r = get(display, text);
+
+        // Not cacheable, the slow way
+        if (r == NULL) {
+            char buf[OLED_COLS / 6 + 1];
+            strncpy_P(buf, text, sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+            display.print(buf, x, y);
+            return;
+        }
+
+        if (x == RIGHT) x = OLED_COLS - r->len;
+        if (x == CENTER) x = (OLED_COLS - r->len) / 2;
+
+        display.blit(arena + r->start, r->len, x, y, display.isInverted());
+    }
+
+    /*
+    =====================
+     const uint8_t *columns
+    =====================
+    */
+    // The rasterized text, NULL if it doesn't fit. The pointer is good
+    // until the next call, the arena may move.
+    const uint8_t *columns(PagedOLED &display, const char *text, uint8_t &len) {
+        TextRun *r = get(display, text);
+
+        if (r == NULL) return NULL;
+
+        len = r->len;
+        return arena + r->start;
+    }
+
+    // Another font: the columns are stale
+    void clear() {
+        for (uint8_t i = 0; i < TEXT_RUNS; i++) runs[i].text = NULL;
+        fill = 0;
+    }
+
+protected:
+    uint8_t arena[TEXT_ARENA];
+    TextRun runs[TEXT_RUNS];
+    uint8_t fill;   // Arena bytes in use, the runs are packed
+    uint8_t tick;
+
+    TextRun *get(PagedOLED &display, const char *text) {
+        TextRun *r = find(text);
+
+        if (r) {
+            hits++;
+        } else {
+            misses++;
+            r = rasterize(display, text);
+        }
+
+        if (r) r->used = ++tick;
+        return r;
+    }
+
+    TextRun *find(const char *text) {
+        for (uint8_t i = 0; i < TEXT_RUNS; i++)
+            if (runs[i].text == text) return &runs[i];
+        return NULL;
+    }
+
+    TextRun *rasterize(PagedOLED &display, const char *text) {
+        uint8_t w = display.fontWidth();
+        int len = strlen_P(text) * w;
+
+        if (display.fontHeight() != 8 || len == 0 || len > TEXT_ARENA)
+            return NULL;
+
+        TextRun *r;
+        while ((r = find(NULL)) == NULL || fill + len > TEXT_ARENA)
+            evict();
+
+        r->text = text;
+        r->start = fill;
+        r->len = len;
+
+        const uint8_t *font = display.fontData() + FONT_HEADER;
+        uint8_t *col = arena + fill;
+        char c;
+
+        while ((c = pgm_read_byte(text++)) != '\0') {
+            memcpy_P(col, font + (c - display.fontOffset()) * w, w);
+            col += w;
+            display.glyphs++;
+        }
+        fill += len;
+
+        return r;
+    }
+
+    // Drop the least recently used run
+    void evict() {
+        TextRun *lru = NULL;
+
+        for (uint8_t i = 0; i < TEXT_RUNS; i++) {
+            TextRun *r = &runs[i];
+            if (r->text == NULL) continue;
+            if (lru == NULL || (uint8_t) (tick - r->used) > (uint8_t) (tick - lru->used))
+                lru = r;
+        }
+
+        memmove(arena + lru->start, arena + lru->start + lru->len,
+                fill - lru->start - lru->len);
+
+        for (uint8_t i = 0; i < TEXT_RUNS; i++)
+            if (runs[i].text && runs[i].start > lru->start)
+                runs[i].start -= lru->len;
+
+        fill -= lru->len;
+        lru->text = NULL;
+    }
+};
+
+#endif